@@ -1,3 +1,7 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
 #include "nrf.h"
 #include "riotee_adc.h"
 #include "riotee.h"
@@ -10,13 +14,80 @@ TEARDOWN_FUN(adc_teardown_ptr);
 /* Number of samples that still need to be taken before buffer is filled. */
 static unsigned int samples_remaining;
 static unsigned int sample_interval_ticks32;
+/* Samples are triggered by hardware and the END event marks the end of the whole buffer */
+static bool hw_paced;
+
+/* Buffers that are filled alternately while streaming */
+static int16_t *stream_bufs[2];
+static unsigned int stream_block_size;
+static riotee_adc_block_cb_t stream_cb;
+static volatile bool stream_running;
+/* Index of the buffer that is currently being filled */
+static volatile unsigned int stream_fill;
+/* Index of the latest completed buffer that the user task has not fetched yet or -1 */
+static volatile int stream_ready;
+/* A completed buffer was overwritten before the user task fetched it */
+static volatile bool stream_overrun;
+/* The user task blocks in riotee_adc_stream_wait(). Other waits must not be woken up by completed blocks. */
+static volatile bool stream_waiting;
+
+/* Watching an input for limit crossings */
+static volatile bool watch_running;
+/* DMA target of the watch samples */
+static int16_t watch_result;
+
+enum {
+  EVT_ADC_LIMIT = EVT_ADC_BASE + 1,
+};
+
+/* PPI channel that triggers a sample on every TIMER3 compare event */
+#define TIMER_PPI_CH 6
+/* PPI channel that starts a watch sample on every RTC2 compare event */
+#define WATCH_PPI_CH 7
+/* Range of the SAADC internal sample rate timer in 16MHz cycles */
+#define SAMPLERATE_CC_MIN 80
+#define SAMPLERATE_CC_MAX 2047
+/* Largest buffer that the SAADC can fill in one go */
+#define RESULT_MAXCNT_MAX 0x7FFF
+
+/* Recalibrate after this many resets */
+#ifndef RIOTEE_ADC_CAL_MAX_RESETS
+#define RIOTEE_ADC_CAL_MAX_RESETS 64
+#endif
+/* Recalibrate if the temperature has changed by more than this many 0.25 degree steps */
+#ifndef RIOTEE_ADC_CAL_MAX_TEMP_DELTA
+#define RIOTEE_ADC_CAL_MAX_TEMP_DELTA 20
+#endif
+
+/* Marks a valid calibration */
+#define CAL_SIGNATURE 0xCA1B0FF5
+
+/* Offset calibration. Part of the checkpoint, such that it survives power failures. */
+static struct {
+  uint32_t signature;
+  /* Offset in LSB of a 14-bit differential conversion */
+  int32_t offset;
+  /* Die temperature at calibration in 0.25 degree steps */
+  int32_t temp;
+  /* Value of runtime_stats.n_reset at calibration */
+  unsigned int n_reset;
+} adc_cal __attribute__((section(".retained_bss")));
 
 /* Inverse gain lookup table, indexed by riotee_adc_gain_t */
 static const float gain_lut[] = {6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 1.0f / 2, 1.0f / 4};
 /* Reference lookup table, indexed by enum riotee_adc_reference_t */
 static const float ref_lut[] = {0.6f, 0.5f};
 
-float riotee_adc_adc2vadc(int16_t adc, riotee_adc_cfg_t *cfg) {
+/* Offset of a 12-bit sample in LSB */
+static inline float cal_offset(riotee_adc_cfg_t *cfg) {
+  if (adc_cal.signature != CAL_SIGNATURE)
+    return 0.0f;
+  /* One LSB of a single-ended conversion spans two LSB of a differential conversion */
+  return (cfg->input_neg != RIOTEE_ADC_INPUT_NC) ? adc_cal.offset / 4.0f : adc_cal.offset / 2.0f;
+}
+
+/* Volts per LSB of a sample taken with the given configuration */
+static float lsb_volts(riotee_adc_cfg_t *cfg) {
   float res_fac;
   /* See nRF52833 Product Specification v1.5 sec 6.21.3*/
   if (cfg->input_neg != RIOTEE_ADC_INPUT_NC) {
@@ -24,26 +95,173 @@ float riotee_adc_adc2vadc(int16_t adc, riotee_adc_cfg_t *cfg) {
   } else {
     res_fac = 1.0f / (1 << 12);
   }
-  return ref_lut[cfg->reference] * ((float)adc) * gain_lut[cfg->gain] * res_fac;
+  return ref_lut[cfg->reference] * gain_lut[cfg->gain] * res_fac;
+}
+
+float riotee_adc_adc2vadc(int16_t adc, riotee_adc_cfg_t *cfg) {
+  return (((float)adc) - cal_offset(cfg)) * lsb_volts(cfg);
+}
+
+void riotee_adc_scale_init(riotee_adc_scale_t *scale, riotee_adc_cfg_t *cfg, float full_scale_v) {
+  float lsb = lsb_volts(cfg);
+  /* Factor from raw sample to Q15 and Q31 */
+  float c15 = lsb / full_scale_v * (1UL << 15);
+  float c31 = c15 * (1UL << 16);
+
+  scale->lsb_v = lsb;
+  scale->offset = cal_offset(cfg);
+
+  /* Normalize the factors to the largest mantissa that fits */
+  scale->shift15 = 0;
+  while ((c15 < 16384.0f) && (scale->shift15 < 30)) {
+    c15 *= 2.0f;
+    scale->shift15++;
+  }
+  scale->mul15 = (c15 > 32767.0f) ? 32767 : (int16_t)(c15 + 0.5f);
+  scale->bias15 = (int32_t)(-scale->offset * scale->mul15);
+  if (scale->shift15)
+    scale->bias15 += (1L << (scale->shift15 - 1));
+
+  scale->shift31 = 0;
+  while ((c31 < 1073741824.0f) && (scale->shift31 < 62)) {
+    c31 *= 2.0f;
+    scale->shift31++;
+  }
+  scale->mul31 = (c31 > 2147483647.0f) ? INT32_MAX : (int32_t)(c31 + 0.5f);
+  scale->bias31 = (int64_t)(-scale->offset * scale->mul31);
+  if (scale->shift31)
+    scale->bias31 += (1LL << (scale->shift31 - 1));
+}
+
+void riotee_adc_conv_f32(float *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale) {
+  const float lsb = scale->lsb_v;
+  const float offset = scale->offset;
+  for (size_t i = 0; i < n; i++)
+    dst[i] = (src[i] - offset) * lsb;
+}
+
+static inline int16_t conv_q15(int16_t x, int32_t mul, int32_t rnd, unsigned int shift) {
+  int32_t y = (x * mul + rnd) >> shift;
+  return (y > INT16_MAX) ? INT16_MAX : ((y < INT16_MIN) ? INT16_MIN : y);
+}
+
+void riotee_adc_conv_q15(int16_t *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale) {
+  const unsigned int shift = scale->shift15;
+  const int32_t rnd = scale->bias15;
+  size_t i = 0;
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+  /* The factor in either half of a word selects the sample that SMLAD multiplies, the other half contributes zero */
+  const uint32_t mul_lo = (uint16_t)scale->mul15;
+  const uint32_t mul_hi = mul_lo << 16;
+  for (; i + 1 < n; i += 2) {
+    uint32_t x, y;
+    memcpy(&x, &src[i], sizeof(x));
+    int32_t lo = __SSAT((int32_t)__SMLAD(x, mul_lo, rnd) >> shift, 16);
+    int32_t hi = __SSAT((int32_t)__SMLAD(x, mul_hi, rnd) >> shift, 16);
+    y = __PKHBT(lo, hi, 16);
+    memcpy(&dst[i], &y, sizeof(y));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = conv_q15(src[i], scale->mul15, rnd, shift);
+}
+
+void riotee_adc_conv_q31(int32_t *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale) {
+  const unsigned int shift = scale->shift31;
+  const int64_t rnd = scale->bias31;
+
+  for (size_t i = 0; i < n; i++) {
+    int64_t y = ((int64_t)src[i] * scale->mul31 + rnd) >> shift;
+    dst[i] = (y > INT32_MAX) ? INT32_MAX : ((y < INT32_MIN) ? INT32_MIN : y);
+  }
 }
 
 static inline void stop_sampling(void) {
-  NRF_SAADC->INTENCLR = SAADC_INTENCLR_END_Msk;
+  NRF_SAADC->INTENCLR = SAADC_INTENCLR_END_Msk | SAADC_INTENCLR_STARTED_Msk;
 
   NRF_RTC0->EVTENCLR = RTC_EVTEN_COMPARE2_Msk;
+  if (hw_paced) {
+    NRF_TIMER3->TASKS_STOP = 1;
+    NRF_PPI->CHENCLR = (1UL << TIMER_PPI_CH);
+    NRF_PPI->FORK[4].TEP = 0;
+    NRF_SAADC->SAMPLERATE = (SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos);
+  }
+  if (stream_running) {
+    stream_running = false;
+    stream_waiting = false;
+    NRF_PPI->CH[5].TEP = (uint32_t)&NRF_SAADC->TASKS_STOP;
+    NRF_PPI->CHENSET = PPI_CHENSET_CH4_Msk;
+  }
   NRF_SAADC->TASKS_STOP = 1;
   NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->EVENTS_STARTED = 0;
+  /* Disconnected inputs disable the channels, such that single channel functions do not scan */
+  for (unsigned int i = 1; i < RIOTEE_ADC_MAX_CHANNELS; i++)
+    NRF_SAADC->CH[i].PSELP = RIOTEE_ADC_INPUT_NC;
 
   NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos);
   adc_teardown_ptr = NULL;
 }
 
+static void stream_irq(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  if (NRF_SAADC->EVENTS_END == 1) {
+    unsigned int done = stream_fill;
+    NRF_SAADC->EVENTS_END = 0;
+    /* PPI has already restarted the SAADC on the other buffer */
+    stream_fill = done ^ 1;
+    if (stream_ready >= 0)
+      stream_overrun = true;
+    stream_ready = done;
+    if (stream_cb != NULL)
+      stream_cb(stream_bufs[done], stream_block_size);
+    if (stream_waiting)
+      xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_ADC_BASE, eSetBits, &xHigherPriorityTaskWoken);
+  }
+  if (NRF_SAADC->EVENTS_STARTED == 1) {
+    NRF_SAADC->EVENTS_STARTED = 0;
+    /* RESULT.PTR is latched on START, so the buffer for the next block can be set up right away */
+    NRF_SAADC->RESULT.PTR = (uint32_t)stream_bufs[stream_fill ^ 1];
+  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void watch_stop(void) {
+  NRF_RTC2->TASKS_STOP = 1;
+  NRF_RTC2->EVTENCLR = RTC_EVTEN_COMPARE0_Msk;
+  NRF_PPI->CHENCLR = (1UL << WATCH_PPI_CH);
+  NRF_SAADC->INTENCLR = SAADC_INTENCLR_CH0LIMITH_Msk | SAADC_INTENCLR_CH0LIMITL_Msk;
+  NRF_SAADC->CH[0].LIMIT = (0x7FFFUL << SAADC_CH_LIMIT_HIGH_Pos) | (0x8000UL << SAADC_CH_LIMIT_LOW_Pos);
+  NRF_SAADC->TASKS_STOP = 1;
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos);
+  watch_running = false;
+  adc_teardown_ptr = NULL;
+}
+
 void SAADC_IRQHandler(void) {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+  if (stream_running) {
+    stream_irq();
+    return;
+  }
+
+  if (watch_running) {
+    if ((NRF_SAADC->EVENTS_CH[0].LIMITH == 1) || (NRF_SAADC->EVENTS_CH[0].LIMITL == 1)) {
+      NRF_SAADC->EVENTS_CH[0].LIMITH = 0;
+      NRF_SAADC->EVENTS_CH[0].LIMITL = 0;
+      watch_stop();
+      xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_ADC_LIMIT, eSetBits, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    return;
+  }
+
   NRF_SAADC->EVENTS_END = 0;
 
-  if (--samples_remaining == 0) {
+  if (hw_paced || (--samples_remaining == 0)) {
     stop_sampling();
     xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_ADC_BASE, eSetBits, &xHigherPriorityTaskWoken);
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
@@ -54,10 +272,77 @@ void SAADC_IRQHandler(void) {
 }
 
 static void teardown(void) {
-  stop_sampling();
+  if (watch_running)
+    watch_stop();
+  else
+    stop_sampling();
   xTaskNotifyIndexed(usr_task_handle, 1, EVT_TEARDOWN, eSetBits);
 }
 
+/* Die temperature in 0.25 degree steps */
+static int32_t temp_read(void) {
+  int32_t temp;
+
+  NRF_TEMP->EVENTS_DATARDY = 0;
+  NRF_TEMP->TASKS_START = 1;
+  while (NRF_TEMP->EVENTS_DATARDY == 0) {
+  };
+  NRF_TEMP->EVENTS_DATARDY = 0;
+  temp = NRF_TEMP->TEMP;
+  NRF_TEMP->TASKS_STOP = 1;
+  return temp;
+}
+
+static bool calibration_due(void) {
+  int32_t dtemp;
+
+  if (adc_cal.signature != CAL_SIGNATURE)
+    return true;
+  if (runtime_stats.n_reset - adc_cal.n_reset >= RIOTEE_ADC_CAL_MAX_RESETS)
+    return true;
+
+  dtemp = temp_read() - adc_cal.temp;
+  return (dtemp > RIOTEE_ADC_CAL_MAX_TEMP_DELTA) || (dtemp < -RIOTEE_ADC_CAL_MAX_TEMP_DELTA);
+}
+
+void riotee_adc_calibrate(void) {
+  int16_t result = 0;
+
+  taskENTER_CRITICAL();
+  /* Both inputs on the same node, such that the result is the offset of the converter itself. The hardware offset
+   * calibration cannot be read back and is lost on every power failure, so the offset is corrected in software. */
+  NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos) |
+                            (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos) |
+                            (SAADC_CH_CONFIG_TACQ_3us << SAADC_CH_CONFIG_TACQ_Pos) |
+                            (SAADC_CH_CONFIG_MODE_Diff << SAADC_CH_CONFIG_MODE_Pos) |
+                            (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+  NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_VDD;
+  NRF_SAADC->CH[0].PSELN = SAADC_CH_PSELN_PSELN_VDD;
+
+  /* Average 64 conversions with two extra bits of resolution */
+  NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_14bit;
+  NRF_SAADC->OVERSAMPLE = RIOTEE_ADC_OVERSAMPLE_64X;
+  NRF_SAADC->RESULT.PTR = (uint32_t)&result;
+  NRF_SAADC->RESULT.MAXCNT = 1;
+
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos);
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->TASKS_START = 1;
+  while (NRF_SAADC->EVENTS_END == 0) {
+  };
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos);
+
+  NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
+  NRF_SAADC->OVERSAMPLE = RIOTEE_ADC_OVERSAMPLE_DISABLED;
+
+  adc_cal.offset = result;
+  adc_cal.temp = temp_read();
+  adc_cal.n_reset = runtime_stats.n_reset;
+  adc_cal.signature = CAL_SIGNATURE;
+  taskEXIT_CRITICAL();
+}
+
 void riotee_adc_init(void) {
   NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
 
@@ -73,7 +358,94 @@ void riotee_adc_init(void) {
   NRF_PPI->CH[5].TEP = (uint32_t)&NRF_SAADC->TASKS_STOP;
   NRF_PPI->CHENSET = PPI_CHENSET_CH5_Msk;
 
+  /* 16MHz timer that paces samples that are too far apart for the SAADC internal timer */
+  NRF_TIMER3->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
+  NRF_TIMER3->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+  NRF_TIMER3->PRESCALER = 0;
+  NRF_TIMER3->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+  NRF_PPI->CH[TIMER_PPI_CH].EEP = (uint32_t)&NRF_TIMER3->EVENTS_COMPARE[0];
+  NRF_PPI->CH[TIMER_PPI_CH].TEP = (uint32_t)&NRF_SAADC->TASKS_SAMPLE;
+
+  /* 32kHz timer that paces the samples while watching an input */
+  NRF_RTC2->PRESCALER = 0;
+  NRF_PPI->CH[WATCH_PPI_CH].EEP = (uint32_t)&NRF_RTC2->EVENTS_COMPARE[0];
+  NRF_PPI->CH[WATCH_PPI_CH].TEP = (uint32_t)&NRF_SAADC->TASKS_START;
+  NRF_PPI->FORK[WATCH_PPI_CH].TEP = (uint32_t)&NRF_RTC2->TASKS_CLEAR;
+
   NVIC_EnableIRQ(SAADC_IRQn);
+
+  if (calibration_due())
+    riotee_adc_calibrate();
+}
+
+/* 32768Hz ticks to 16MHz cycles. Computed in 64 bits as the product overflows above ~8.4s. */
+static inline uint64_t ticks2cycles(unsigned int ticks32) {
+  return ((uint64_t)ticks32 * 15625 + 16) / 32;
+}
+
+/* Checks that a sample interval is non-zero and fits into the 32-bit compare register of TIMER3 (~268s) */
+static inline bool interval_valid(unsigned int ticks32) {
+  return (ticks32 > 0) && (ticks2cycles(ticks32) <= UINT32_MAX);
+}
+
+/* Lets TIMER3 trigger a sample every given number of 16MHz cycles */
+static void timer_pacing_cfg(uint32_t cycles) {
+  NRF_TIMER3->CC[0] = cycles;
+  NRF_TIMER3->TASKS_CLEAR = 1;
+  NRF_PPI->CHENSET = (1UL << TIMER_PPI_CH);
+}
+
+/* Sets up hardware triggering of samples. Returns true if TIMER3 has to be started together with the first sample. */
+static bool pacing_cfg(riotee_adc_cfg_t *cfg) {
+  uint32_t cycles = (uint32_t)ticks2cycles(cfg->sample_interval_ticks32);
+
+  if ((cycles >= SAMPLERATE_CC_MIN) && (cycles <= SAMPLERATE_CC_MAX) &&
+      (cfg->oversampling == RIOTEE_ADC_OVERSAMPLE_DISABLED)) {
+    /* The first SAMPLE task starts the internal timer */
+    NRF_SAADC->SAMPLERATE =
+        (cycles << SAADC_SAMPLERATE_CC_Pos) | (SAADC_SAMPLERATE_MODE_Timers << SAADC_SAMPLERATE_MODE_Pos);
+    return false;
+  }
+  timer_pacing_cfg(cycles);
+  return true;
+}
+
+/* Lets hardware trigger all samples. The first one is taken as soon as the SAADC has started. */
+static void start_hw_pacing(riotee_adc_cfg_t *cfg) {
+  if (pacing_cfg(cfg))
+    NRF_PPI->FORK[4].TEP = (uint32_t)&NRF_TIMER3->TASKS_START;
+  NRF_SAADC->TASKS_START = 1;
+}
+
+/* Configures one channel of the SAADC */
+static void channel_cfg(unsigned int ch, const riotee_adc_ch_cfg_t *cfg, riotee_adc_oversample_t oversampling) {
+  NRF_SAADC->CH[ch].CONFIG = ((cfg->gain << SAADC_CH_CONFIG_GAIN_Pos) & SAADC_CH_CONFIG_GAIN_Msk) |
+                             ((cfg->reference << SAADC_CH_CONFIG_REFSEL_Pos) & SAADC_CH_CONFIG_REFSEL_Msk) |
+                             ((cfg->acq_time << SAADC_CH_CONFIG_TACQ_Pos) & SAADC_CH_CONFIG_TACQ_Msk) |
+                             (cfg->res_pos << SAADC_CH_CONFIG_RESP_Pos) | (cfg->res_neg << SAADC_CH_CONFIG_RESN_Pos);
+
+  /* If oversampling is enabled, take samples as fast as possible in burst mode */
+  if (oversampling != RIOTEE_ADC_OVERSAMPLE_DISABLED)
+    NRF_SAADC->CH[ch].CONFIG |= (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+
+  NRF_SAADC->CH[ch].PSELP = cfg->input_pos;
+  NRF_SAADC->CH[ch].PSELN = cfg->input_neg;
+  if (cfg->input_neg != RIOTEE_ADC_INPUT_NC)
+    NRF_SAADC->CH[ch].CONFIG |= (SAADC_CH_CONFIG_MODE_Diff << SAADC_CH_CONFIG_MODE_Pos);
+}
+
+/* Configures channel 0 of the SAADC for single channel sampling */
+static void single_cfg(riotee_adc_cfg_t *cfg) {
+  riotee_adc_ch_cfg_t ch_cfg = {.gain = cfg->gain,
+                                .reference = cfg->reference,
+                                .acq_time = cfg->acq_time,
+                                .input_pos = cfg->input_pos,
+                                .input_neg = cfg->input_neg,
+                                .res_pos = cfg->res_pos,
+                                .res_neg = cfg->res_neg};
+
+  NRF_SAADC->OVERSAMPLE = cfg->oversampling;
+  channel_cfg(0, &ch_cfg, cfg->oversampling);
 }
 
 int16_t riotee_adc_read(riotee_adc_input_t in) {
@@ -102,36 +474,33 @@ int16_t riotee_adc_read(riotee_adc_input_t in) {
   NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos);
 
   taskEXIT_CRITICAL();
+  /* Single-ended: two 14-bit differential LSB per LSB, rounded */
+  if (adc_cal.signature == CAL_SIGNATURE)
+    result -= (adc_cal.offset + ((adc_cal.offset >= 0) ? 1 : -1)) / 2;
   return result;
 }
 riotee_rc_t riotee_adc_sample(int16_t *dst, riotee_adc_cfg_t *cfg) {
   unsigned long notification_value;
 
+  if ((cfg->pacing == RIOTEE_ADC_PACING_HW) &&
+      ((cfg->n_samples > RESULT_MAXCNT_MAX) || !interval_valid(cfg->sample_interval_ticks32)))
+    return RIOTEE_ERR_INVALIDARG;
+
   taskENTER_CRITICAL();
   NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos);
 
-  NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_RESP_Bypass << SAADC_CH_CONFIG_RESP_Pos) |
-                            (SAADC_CH_CONFIG_RESN_Bypass << SAADC_CH_CONFIG_RESN_Pos) |
-                            ((cfg->gain << SAADC_CH_CONFIG_GAIN_Pos) & SAADC_CH_CONFIG_GAIN_Msk) |
-                            ((cfg->reference << SAADC_CH_CONFIG_REFSEL_Pos) & SAADC_CH_CONFIG_REFSEL_Msk) |
-                            ((cfg->acq_time << SAADC_CH_CONFIG_TACQ_Pos) & SAADC_CH_CONFIG_TACQ_Msk);
-
-  /* If oversampling is enabled, take samples as fast as possible in burst mode */
-  NRF_SAADC->OVERSAMPLE = cfg->oversampling;
-  if (cfg->oversampling != RIOTEE_ADC_OVERSAMPLE_DISABLED)
-    NRF_SAADC->CH[0].CONFIG |= (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+  single_cfg(cfg);
 
-  NRF_SAADC->CH[0].PSELP = cfg->input_pos;
-  NRF_SAADC->CH[0].PSELN = cfg->input_neg;
-  if (cfg->input_neg != RIOTEE_ADC_INPUT_NC)
-    NRF_SAADC->CH[0].CONFIG |= (SAADC_CH_CONFIG_MODE_Diff << SAADC_CH_CONFIG_MODE_Pos);
-
-  NRF_SAADC->CH[0].CONFIG |= (cfg->res_pos << SAADC_CH_CONFIG_RESP_Pos) | (cfg->res_neg << SAADC_CH_CONFIG_RESN_Pos);
-
-  /* Take only one sample, manage buffer in software */
   NRF_SAADC->RESULT.PTR = (uint32_t)dst;
-  NRF_SAADC->RESULT.MAXCNT = 1;
-  samples_remaining = cfg->n_samples;
+  hw_paced = (cfg->pacing == RIOTEE_ADC_PACING_HW);
+  if (hw_paced) {
+    /* Fill the whole buffer via DMA */
+    NRF_SAADC->RESULT.MAXCNT = cfg->n_samples;
+  } else {
+    /* Take only one sample, manage buffer in software */
+    NRF_SAADC->RESULT.MAXCNT = 1;
+    samples_remaining = cfg->n_samples;
+  }
 
   xTaskNotifyStateClearIndexed(usr_task_handle, 1);
   ulTaskNotifyValueClearIndexed(usr_task_handle, 1, 0xFFFFFFFF);
@@ -141,7 +510,9 @@ riotee_rc_t riotee_adc_sample(int16_t *dst, riotee_adc_cfg_t *cfg) {
   /* Register teardown function so runtime can abort us */
   adc_teardown_ptr = teardown;
 
-  if (cfg->n_samples > 1) {
+  if (hw_paced) {
+    start_hw_pacing(cfg);
+  } else if (cfg->n_samples > 1) {
     sample_interval_ticks32 = cfg->sample_interval_ticks32;
     NRF_RTC0->CC[2] = (NRF_RTC0->COUNTER + cfg->sample_interval_ticks32) % (1 << 24);
     NRF_RTC0->EVTENSET = RTC_EVTEN_COMPARE2_Msk;
@@ -160,3 +531,224 @@ riotee_rc_t riotee_adc_sample(int16_t *dst, riotee_adc_cfg_t *cfg) {
 
   return RIOTEE_ERR_GENERIC;
 }
+
+riotee_rc_t riotee_adc_scan(int16_t *dst, riotee_adc_scan_cfg_t *cfg) {
+  unsigned long notification_value;
+
+  if ((cfg->n_channels == 0) || (cfg->n_channels > RIOTEE_ADC_MAX_CHANNELS) || (cfg->n_scans == 0))
+    return RIOTEE_ERR_INVALIDARG;
+  if (cfg->n_channels * cfg->n_scans > RESULT_MAXCNT_MAX)
+    return RIOTEE_ERR_INVALIDARG;
+  if ((cfg->n_scans > 1) && !interval_valid(cfg->sample_interval_ticks32))
+    return RIOTEE_ERR_INVALIDARG;
+
+  taskENTER_CRITICAL();
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos);
+
+  /* One SAMPLE task converts all channels with a connected input in turn */
+  NRF_SAADC->OVERSAMPLE = cfg->oversampling;
+  for (unsigned int i = 0; i < cfg->n_channels; i++)
+    channel_cfg(i, &cfg->channels[i], cfg->oversampling);
+
+  NRF_SAADC->RESULT.PTR = (uint32_t)dst;
+  NRF_SAADC->RESULT.MAXCNT = cfg->n_channels * cfg->n_scans;
+  hw_paced = true;
+
+  xTaskNotifyStateClearIndexed(usr_task_handle, 1);
+  ulTaskNotifyValueClearIndexed(usr_task_handle, 1, 0xFFFFFFFF);
+
+  NRF_SAADC->INTENSET = SAADC_INTENSET_END_Msk;
+
+  /* Register teardown function so runtime can abort us */
+  adc_teardown_ptr = teardown;
+
+  /* The internal timer of the SAADC does not work in scan mode */
+  if (cfg->n_scans > 1) {
+    timer_pacing_cfg((uint32_t)ticks2cycles(cfg->sample_interval_ticks32));
+    NRF_PPI->FORK[4].TEP = (uint32_t)&NRF_TIMER3->TASKS_START;
+  }
+  NRF_SAADC->TASKS_START = 1;
+
+  taskEXIT_CRITICAL();
+
+  xTaskNotifyWaitIndexed(1, 0x0, 0xFFFFFFFF, &notification_value, portMAX_DELAY);
+
+  if (notification_value & EVT_RESET)
+    return RIOTEE_ERR_RESET;
+  if (notification_value & EVT_TEARDOWN)
+    return RIOTEE_ERR_TEARDOWN;
+  if (notification_value == EVT_ADC_BASE)
+    return RIOTEE_SUCCESS;
+
+  return RIOTEE_ERR_GENERIC;
+}
+
+void riotee_adc_deinterleave(int16_t **dst, const int16_t *src, unsigned int n_channels, unsigned int n_scans) {
+  for (unsigned int i = 0; i < n_scans; i++) {
+    for (unsigned int ch = 0; ch < n_channels; ch++)
+      dst[ch][i] = *src++;
+  }
+}
+
+riotee_rc_t riotee_adc_stream_start(riotee_adc_cfg_t *cfg, int16_t *buf_a, int16_t *buf_b, unsigned int block_size,
+                                    riotee_adc_block_cb_t cb) {
+  bool use_timer;
+
+  if ((block_size == 0) || (block_size > RESULT_MAXCNT_MAX) || !interval_valid(cfg->sample_interval_ticks32))
+    return RIOTEE_ERR_INVALIDARG;
+
+  taskENTER_CRITICAL();
+  if (stream_running) {
+    taskEXIT_CRITICAL();
+    return RIOTEE_ERR_GENERIC;
+  }
+
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos);
+  single_cfg(cfg);
+
+  stream_bufs[0] = buf_a;
+  stream_bufs[1] = buf_b;
+  stream_block_size = block_size;
+  stream_cb = cb;
+  stream_fill = 0;
+  stream_ready = -1;
+  stream_overrun = false;
+  hw_paced = true;
+  stream_running = true;
+
+  /* Every completed block immediately restarts the SAADC on the other buffer. Samples are only triggered by the timer,
+   * such that the interval between the last sample of a block and the first sample of the next stays the same. */
+  NRF_PPI->CHENCLR = PPI_CHENCLR_CH4_Msk;
+  NRF_PPI->CH[5].TEP = (uint32_t)&NRF_SAADC->TASKS_START;
+
+  NRF_SAADC->RESULT.PTR = (uint32_t)buf_a;
+  NRF_SAADC->RESULT.MAXCNT = block_size;
+  use_timer = pacing_cfg(cfg);
+
+  NRF_SAADC->EVENTS_STARTED = 0;
+  NRF_SAADC->TASKS_START = 1;
+  while (NRF_SAADC->EVENTS_STARTED == 0) {
+  };
+  NRF_SAADC->EVENTS_STARTED = 0;
+  NRF_SAADC->RESULT.PTR = (uint32_t)buf_b;
+
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->INTENSET = SAADC_INTENSET_END_Msk | SAADC_INTENSET_STARTED_Msk;
+
+  /* Register teardown function so runtime can abort us */
+  adc_teardown_ptr = teardown;
+
+  /* Takes the first sample and starts the internal timer */
+  NRF_SAADC->TASKS_SAMPLE = 1;
+  if (use_timer)
+    NRF_TIMER3->TASKS_START = 1;
+
+  taskEXIT_CRITICAL();
+  return RIOTEE_SUCCESS;
+}
+
+riotee_rc_t riotee_adc_stream_wait(int16_t **block) {
+  unsigned long notification_value;
+  riotee_rc_t rc;
+
+  for (;;) {
+    taskENTER_CRITICAL();
+    if (stream_ready >= 0) {
+      *block = stream_bufs[stream_ready];
+      stream_ready = -1;
+      rc = stream_overrun ? RIOTEE_ERR_OVERFLOW : RIOTEE_SUCCESS;
+      stream_overrun = false;
+      taskEXIT_CRITICAL();
+      return rc;
+    }
+    if (!stream_running) {
+      taskEXIT_CRITICAL();
+      return RIOTEE_ERR_GENERIC;
+    }
+    xTaskNotifyStateClearIndexed(usr_task_handle, 1);
+    ulTaskNotifyValueClearIndexed(usr_task_handle, 1, 0xFFFFFFFF);
+    stream_waiting = true;
+    taskEXIT_CRITICAL();
+
+    xTaskNotifyWaitIndexed(1, 0x0, 0xFFFFFFFF, &notification_value, portMAX_DELAY);
+    stream_waiting = false;
+
+    if (notification_value & EVT_RESET)
+      return RIOTEE_ERR_RESET;
+    if (notification_value & EVT_TEARDOWN)
+      return RIOTEE_ERR_TEARDOWN;
+  }
+}
+
+void riotee_adc_stream_stop(void) {
+  taskENTER_CRITICAL();
+  if (stream_running)
+    stop_sampling();
+  taskEXIT_CRITICAL();
+}
+
+/* Converts a value as returned by riotee_adc_read() into the raw value that the SAADC compares to its limits */
+static int32_t read2raw(int32_t value) {
+  if (adc_cal.signature == CAL_SIGNATURE)
+    value += (adc_cal.offset + ((adc_cal.offset >= 0) ? 1 : -1)) / 2;
+  return (value > INT16_MAX) ? INT16_MAX : ((value < INT16_MIN) ? INT16_MIN : value);
+}
+
+riotee_rc_t riotee_adc_watch(riotee_adc_watch_cfg_t *cfg, int16_t *value) {
+  unsigned long notification_value;
+
+  if ((cfg->sample_interval_ticks32 == 0) || (cfg->sample_interval_ticks32 >= (1UL << 24)))
+    return RIOTEE_ERR_INVALIDARG;
+  if (cfg->limit_low > cfg->limit_high)
+    return RIOTEE_ERR_INVALIDARG;
+
+  taskENTER_CRITICAL();
+  /* Same configuration as riotee_adc_read() */
+  NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_GAIN_Gain1_4 << SAADC_CH_CONFIG_GAIN_Pos) |
+                            (SAADC_CH_CONFIG_REFSEL_VDD1_4 << SAADC_CH_CONFIG_REFSEL_Pos) |
+                            (SAADC_CH_CONFIG_TACQ_5us << SAADC_CH_CONFIG_TACQ_Pos);
+  NRF_SAADC->CH[0].PSELP = cfg->input;
+  NRF_SAADC->CH[0].PSELN = RIOTEE_ADC_INPUT_NC;
+  NRF_SAADC->OVERSAMPLE = RIOTEE_ADC_OVERSAMPLE_DISABLED;
+  NRF_SAADC->CH[0].LIMIT = (((uint32_t)read2raw(cfg->limit_high) & 0xFFFF) << SAADC_CH_LIMIT_HIGH_Pos) |
+                           (((uint32_t)read2raw(cfg->limit_low) & 0xFFFF) << SAADC_CH_LIMIT_LOW_Pos);
+  NRF_SAADC->RESULT.PTR = (uint32_t)&watch_result;
+  NRF_SAADC->RESULT.MAXCNT = 1;
+  NRF_SAADC->ENABLE = (SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos);
+
+  xTaskNotifyStateClearIndexed(usr_task_handle, 1);
+  ulTaskNotifyValueClearIndexed(usr_task_handle, 1, 0xFFFFFFFF);
+
+  /* Only a crossing wakes up the CPU. Each sample is started by RTC2 and stopped again via PPI. */
+  NRF_SAADC->EVENTS_CH[0].LIMITH = 0;
+  NRF_SAADC->EVENTS_CH[0].LIMITL = 0;
+  NRF_SAADC->INTENSET = SAADC_INTENSET_CH0LIMITH_Msk | SAADC_INTENSET_CH0LIMITL_Msk;
+  watch_running = true;
+
+  /* Register teardown function so runtime can abort us */
+  adc_teardown_ptr = teardown;
+
+  NRF_RTC2->TASKS_CLEAR = 1;
+  NRF_RTC2->CC[0] = cfg->sample_interval_ticks32;
+  NRF_RTC2->EVTENSET = RTC_EVTEN_COMPARE0_Msk;
+  NRF_PPI->CHENSET = (1UL << WATCH_PPI_CH);
+  NRF_RTC2->TASKS_START = 1;
+
+  taskEXIT_CRITICAL();
+
+  xTaskNotifyWaitIndexed(1, 0x0, 0xFFFFFFFF, &notification_value, portMAX_DELAY);
+
+  if (notification_value & EVT_RESET)
+    return RIOTEE_ERR_RESET;
+  if (notification_value & EVT_TEARDOWN)
+    return RIOTEE_ERR_TEARDOWN;
+  if (notification_value != EVT_ADC_LIMIT)
+    return RIOTEE_ERR_GENERIC;
+
+  if (value != NULL) {
+    *value = watch_result;
+    if (adc_cal.signature == CAL_SIGNATURE)
+      *value -= (adc_cal.offset + ((adc_cal.offset >= 0) ? 1 : -1)) / 2;
+  }
+  return RIOTEE_SUCCESS;
+}
@@ -14,20 +14,124 @@
 /* Bluetooth Core Spec 5.2 Section 2.1.2 */
 #define ADV_CHANNEL_AA 0x8E89BED6
 
-static riotee_adv_pck_t adv_pkt;
-
-/* pointer to custom user data within adv_pkt */
-static uint8_t *adv_data_pkt;
+/* Two advertising packets. The radio transmits one while the application prepares the other. */
+static riotee_adv_pck_t adv_pkts[2];
+/* Index of the packet that is transmitted by the radio */
+static unsigned int adv_active;
+/* Inactive packet has been committed and replaces the active packet at the next channel boundary */
+static volatile bool adv_pending;
+/* An advertising event is in progress */
+static volatile bool adv_running;
+/* The inactive packet was swapped out while on air and may still be read by the radio */
+static volatile bool adv_draining;
+
+/* Radio configuration and callbacks of BLE */
+static radio_ctx_t ble_ctx;
+
+/* offset of custom user data within the packet payload */
+static size_t adv_data_offset;
 /* user-provided pointer to custom user data */
 static void *adv_data_usr;
 /* length of custom user data within adv_pkt */
 static size_t adv_data_len;
 
-static unsigned int adv_chs[3];
-static unsigned int current_adv_ch_idx;
+typedef struct {
+  uint8_t frequency;
+  uint8_t datawhiteiv;
+} adv_ch_cfg_t;
+
+/* Radio settings for the channels of the current advertising event in order of transmission */
+static adv_ch_cfg_t adv_seq[3];
+static unsigned int adv_seq_len;
+/* Index of the channel that is currently transmitted */
+static volatile unsigned int adv_seq_idx;
+
+/* Unit of the AUX Offset field in microseconds */
+#define EXT_OFFSET_UNIT_US 30
+/* Minimum time between the end of a packet with an AuxPtr and the start of the auxiliary packet (T_MAFS) */
+#define EXT_MAFS_US 300
+/* Fast radio ramp-up */
+#define RAMPUP_US 40
+/* PPI channel triggering the packets of an extended advertising event from TIMER1 */
+#define EXT_PPI_CH 17
+
+/* Flags of the extended header, Bluetooth Core Spec 5.2 Vol 6 Part B Section 2.3.4 */
+#define EXT_HDR_ADVA (1UL << 0)
+#define EXT_HDR_ADI (1UL << 3)
+#define EXT_HDR_AUXPTR (1UL << 4)
+
+/* ADV_EXT_IND with ADI and AuxPtr only */
+typedef struct {
+  riotee_ble_adv_header_t header;
+  uint8_t payload[7];
+} __attribute__((__packed__)) ext_prim_pck_t;
+
+typedef struct {
+  adv_ch_cfg_t ch;
+  const void *pkt;
+  riotee_ble_phy_t phy;
+} ext_step_t;
+
+typedef struct {
+  uint8_t mode;
+  uint8_t plen;
+  /* Air time of one byte of PDU and CRC */
+  uint8_t us_per_byte;
+  /* Air time of preamble, access address and coding indicator and terminators on the Coded PHY */
+  uint16_t overhead_us;
+} phy_cfg_t;
+
+/* Bluetooth Core Spec 5.2 Vol 6 Part B Section 2.2 */
+static const phy_cfg_t phy_cfgs[] = {
+    [RIOTEE_BLE_PHY_1M] = {RADIO_MODE_MODE_Ble_1Mbit, RADIO_PCNF0_PLEN_8bit, 8, 8 + 32},
+    [RIOTEE_BLE_PHY_2M] = {RADIO_MODE_MODE_Ble_2Mbit, RADIO_PCNF0_PLEN_16bit, 4, 8 + 16},
+    /* Preamble, access address, CI and TERM1 are always S8 coded */
+    [RIOTEE_BLE_PHY_CODED_S2] = {RADIO_MODE_MODE_Ble_LR500Kbit, RADIO_PCNF0_PLEN_LongRange, 16, 80 + 256 + 16 + 24 + 6},
+    [RIOTEE_BLE_PHY_CODED_S8] = {RADIO_MODE_MODE_Ble_LR125Kbit, RADIO_PCNF0_PLEN_LongRange, 64,
+                                 80 + 256 + 16 + 24 + 24},
+};
+
+/* Value of the AUX PHY field in the AuxPtr */
+static const uint8_t phy_auxptr[] = {
+    [RIOTEE_BLE_PHY_1M] = 0, [RIOTEE_BLE_PHY_2M] = 1, [RIOTEE_BLE_PHY_CODED_S2] = 2, [RIOTEE_BLE_PHY_CODED_S8] = 2};
+
+/* One ADV_EXT_IND per primary channel, as each one has a different offset to the AUX_ADV_IND */
+static ext_prim_pck_t ext_prim_pkts[3];
+static riotee_adv_ext_pck_t ext_aux_pkt;
+/* Advertising data ID and set ID */
+static uint16_t ext_adi;
+/* Interval between the packets of an extended advertising event in microseconds */
+static unsigned int ext_spacing_us;
+/* Offset of the ADI within the auxiliary packet payload */
+#define EXT_AUX_ADI_OFFSET (2 + 6)
+
+static size_t ext_data_offset;
+static void *ext_data_usr;
+static size_t ext_data_len;
+
+/* Channels and packets of an extended advertising event in order of transmission */
+static ext_step_t ext_seq[4];
+static volatile unsigned int ext_seq_idx;
+
+/* PPI channel that ends a scan window */
+#define SCAN_PPI_CH 16
+
+/* Large enough for any PDU that fits into MAXLEN, as the radio writes whatever it receives */
+static riotee_adv_ext_pck_t scan_pkt;
+static riotee_ble_scan_result_t *scan_res;
+static uint16_t scan_mnf_id;
+static volatile bool scan_matched;
 
 TEARDOWN_FUN(ble_teardown_ptr);
 
+static void radio_address_callback(void);
+static void radio_ext_address_callback(void);
+static void radio_ext_disabled_callback(void);
+static void radio_disabled_callback(void);
+static void radio_scan_crcok_callback(void);
+static void radio_scan_crcerr_callback(void);
+static void radio_scan_disabled_callback(void);
+
 static __inline int8_t ch2freq(uint8_t ch) {
   switch (ch) {
     case 37:
@@ -46,77 +150,145 @@ static __inline int8_t ch2freq(uint8_t ch) {
   }
 }
 
+/* Stops TIMER1 from triggering further packets of an extended advertising event */
+static inline void ext_stop(void) {
+  NRF_PPI->CHENCLR = (1UL << EXT_PPI_CH);
+  NRF_PPI->FORK[18].TEP = 0;
+  NRF_TIMER1->TASKS_STOP = 1;
+}
+
+/* Restores transmit mode after scanning */
+static inline void scan_stop(void) {
+  NRF_PPI->CHENCLR = (1UL << SCAN_PPI_CH);
+  NRF_PPI->FORK[18].TEP = 0;
+  NRF_PPI->CH[18].TEP = (uint32_t)&NRF_RADIO->TASKS_TXEN;
+  NRF_TIMER1->TASKS_STOP = 1;
+  NRF_RADIO->DACNF = 0;
+  NRF_RADIO->SHORTS = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk;
+  radio_cb_unregister(RADIO_EVT_CRCOK);
+  radio_cb_unregister(RADIO_EVT_CRCERR);
+}
+
 void teardown(void) {
+  /* Break the chain first, otherwise disabling the radio starts the next transmission */
+  NRF_RADIO->SHORTS &= ~RADIO_SHORTS_DISABLED_TXEN_Msk;
+  ext_stop();
+  scan_stop();
+  radio_cb_unregister(RADIO_EVT_ADDRESS);
+  radio_cb_unregister(RADIO_EVT_DISABLED);
   radio_stop();
+  adv_running = false;
+  adv_draining = false;
   ble_teardown_ptr = NULL;
   xTaskNotifyIndexed(usr_task_handle, 1, EVT_TEARDOWN, eSetBits);
 }
 
 riotee_rc_t riotee_ble_adv_cfg(riotee_ble_adv_cfg_t *cfg) {
-  const unsigned int payload_free = sizeof(adv_pkt.payload) - 8;
+  riotee_adv_pck_t *adv_pkt = &adv_pkts[0];
+  const unsigned int payload_free = sizeof(adv_pkt->payload) - 8;
 
   if (cfg->name_len > payload_free)
     return RIOTEE_ERR_OVERFLOW;
   if (cfg->data_len + cfg->name_len > payload_free)
     return RIOTEE_ERR_OVERFLOW;
 
-  adv_pkt.header.pdu_type = ADV_NONCONN_IND;
-  adv_pkt.header.txadd = 1;
-  memcpy(adv_pkt.adv_addr, cfg->addr, 6);
+  adv_pkt->header.pdu_type = ADV_NONCONN_IND;
+  adv_pkt->header.txadd = 1;
+  memcpy(adv_pkt->adv_addr, cfg->addr, 6);
 
   /* Length of advertising mode field */
-  adv_pkt.payload[0] = 0x02;
+  adv_pkt->payload[0] = 0x02;
   /* Type for advertising mode field */
-  adv_pkt.payload[1] = 0x01;
+  adv_pkt->payload[1] = 0x01;
   /* BR/EDR not supported | LE general discoverability mode */
-  adv_pkt.payload[2] = (1UL << 2) | (1UL << 1);
+  adv_pkt->payload[2] = (1UL << 2) | (1UL << 1);
   /* Length of name field */
-  adv_pkt.payload[3] = cfg->name_len + 1;
+  adv_pkt->payload[3] = cfg->name_len + 1;
   /* Type for name field */
-  adv_pkt.payload[4] = 0x09;
-  memcpy(&adv_pkt.payload[5], cfg->name, cfg->name_len);
+  adv_pkt->payload[4] = 0x09;
+  memcpy(&adv_pkt->payload[5], cfg->name, cfg->name_len);
   /* MNF data length: 3B header + length of custom data */
-  adv_pkt.payload[5 + cfg->name_len] = 3 + cfg->data_len;
+  adv_pkt->payload[5 + cfg->name_len] = 3 + cfg->data_len;
   /* Type for MNF-specific data field */
-  adv_pkt.payload[5 + cfg->name_len + 1] = 0xFF;
+  adv_pkt->payload[5 + cfg->name_len + 1] = 0xFF;
   /* Two byte company ID (Nordic Semiconductor) */
-  memcpy(adv_pkt.payload + 5 + cfg->name_len + 2, &cfg->manufacturer_id, 2);
+  memcpy(adv_pkt->payload + 5 + cfg->name_len + 2, &cfg->manufacturer_id, 2);
 
-  adv_data_pkt = &adv_pkt.payload[5 + cfg->name_len + 4];
+  adv_data_offset = 5 + cfg->name_len + 4;
   adv_data_usr = cfg->data;
   adv_data_len = cfg->data_len;
 
-  adv_pkt.header.len = sizeof(riotee_ble_adv_addr_t) + 5 + cfg->name_len + 4 + cfg->data_len;
+  adv_pkt->header.len = sizeof(riotee_ble_adv_addr_t) + 5 + cfg->name_len + 4 + cfg->data_len;
+
+  /* Both packets share everything but the custom data */
+  memcpy(&adv_pkts[1], &adv_pkts[0], sizeof(riotee_adv_pck_t));
+  adv_active = 0;
+  adv_pending = false;
 
   return RIOTEE_SUCCESS;
 }
 
-/* Configure the radio for the given BLE channel index */
-static inline int set_channel(unsigned int adv_ch_idx) {
-  NRF_RADIO->FREQUENCY = ch2freq(adv_chs[adv_ch_idx]);
+/* Makes a committed packet the active one. The radio only samples PACKETPTR when a packet starts, but the caller must
+ * keep the application away from the previous packet while it is still on air (see adv_draining). */
+static inline void adv_swap(void) {
+  if (adv_pending) {
+    adv_active ^= 1;
+    adv_pending = false;
+  }
+  NRF_RADIO->PACKETPTR = (uint32_t)&adv_pkts[adv_active];
+}
+
+void *riotee_ble_adv_data(void) {
+  if (adv_pending || adv_draining)
+    return NULL;
+  return &adv_pkts[adv_active ^ 1].payload[adv_data_offset];
+}
+
+void riotee_ble_adv_commit(void) {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  adv_pending = true;
+  /* Otherwise, the packets are swapped at the next channel boundary */
+  if (!adv_running)
+    adv_swap();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static inline void adv_seq_add(unsigned int ch) {
+  adv_seq[adv_seq_len].frequency = ch2freq(ch);
   /* Whitening initialization see Bluetooth Core Spec 5.2 Section 3.2 */
-  NRF_RADIO->DATAWHITEIV = adv_chs[adv_ch_idx] & 0x3F;
-  return 0;
+  adv_seq[adv_seq_len].datawhiteiv = ch & 0x3F;
+  adv_seq_len++;
 }
 
-riotee_rc_t riotee_ble_advertise(riotee_adv_ch_t ch) {
-  unsigned long notification_value;
+/* Configure the radio for the given BLE channel. Takes effect with the next TXEN. */
+static inline void set_channel(const adv_ch_cfg_t *cfg) {
+  NRF_RADIO->FREQUENCY = cfg->frequency;
+  NRF_RADIO->DATAWHITEIV = cfg->datawhiteiv;
+}
 
-  /* Copy user data into advertisement packet */
-  memcpy(adv_data_pkt, adv_data_usr, adv_data_len);
+/* Configures MODE and preamble for the given PHY. Takes effect with the next TXEN. */
+static inline void set_phy(riotee_ble_phy_t phy) {
+  uint32_t pcnf0 = NRF_RADIO->PCNF0 & ~(RADIO_PCNF0_PLEN_Msk | RADIO_PCNF0_CILEN_Msk | RADIO_PCNF0_TERMLEN_Msk);
 
-  if (ch == ADV_CH_ALL) {
-    adv_chs[0] = 39;
-    adv_chs[1] = 38;
-    adv_chs[2] = 37;
-    current_adv_ch_idx = 2;
-  } else {
-    adv_chs[0] = ch;
-    current_adv_ch_idx = 0;
-  }
+  pcnf0 |= phy_cfgs[phy].plen << RADIO_PCNF0_PLEN_Pos;
+  /* Coding indicator and terminator on the Coded PHY */
+  if ((phy == RIOTEE_BLE_PHY_CODED_S2) || (phy == RIOTEE_BLE_PHY_CODED_S8))
+    pcnf0 |= (2UL << RADIO_PCNF0_CILEN_Pos) | (3UL << RADIO_PCNF0_TERMLEN_Pos);
 
-  taskENTER_CRITICAL();
-  set_channel(current_adv_ch_idx);
+  NRF_RADIO->MODE = phy_cfgs[phy].mode << RADIO_MODE_MODE_Pos;
+  NRF_RADIO->PCNF0 = pcnf0;
+}
+
+/* Air time of a packet with the given PDU length in microseconds */
+static inline unsigned int phy_airtime_us(riotee_ble_phy_t phy, unsigned int pdu_len) {
+  /* PDU header and CRC */
+  return phy_cfgs[phy].overhead_us + (2 + pdu_len + 3) * phy_cfgs[phy].us_per_byte;
+}
+
+/* Starts the prepared advertising event and waits for it to complete. Must be called from within a critical section,
+ * which is left while waiting. */
+static riotee_rc_t adv_event_run(void) {
+  unsigned long notification_value;
 
   radio_start();
   xTaskNotifyStateClearIndexed(usr_task_handle, 1);
@@ -137,24 +309,351 @@ riotee_rc_t riotee_ble_advertise(riotee_adv_ch_t ch) {
   return RIOTEE_ERR_GENERIC;
 }
 
-/* Gets called after a single packet has been transmitted and the radio has been disabled (via short) */
-void radio_disabled_callback() {
-  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+riotee_rc_t riotee_ble_advertise(riotee_adv_ch_t ch) {
+  /* Copy user data into advertisement packet unless the application writes it directly */
+  if (adv_data_usr != NULL) {
+    void *dst = riotee_ble_adv_data();
+    if (dst != NULL) {
+      memcpy(dst, adv_data_usr, adv_data_len);
+      riotee_ble_adv_commit();
+    }
+  }
+
+  adv_seq_len = 0;
+  if (ch == ADV_CH_ALL) {
+    adv_seq_add(37);
+    adv_seq_add(38);
+    adv_seq_add(39);
+  } else {
+    adv_seq_add(ch);
+  }
+  adv_seq_idx = 0;
 
-  /* If we still have channels to advertise on */
-  if (current_adv_ch_idx > 0) {
-    set_channel(--current_adv_ch_idx);
-    NRF_RADIO->TASKS_TXEN = 1;
+  taskENTER_CRITICAL();
+  radio_ctx_activate(&ble_ctx);
+  set_channel(&adv_seq[0]);
+  /* Legacy advertising is only defined for the 1M PHY */
+  set_phy(RIOTEE_BLE_PHY_1M);
+  adv_swap();
+  adv_running = true;
+
+  if (adv_seq_len > 1) {
+    /* The radio starts the next channel by itself as soon as the previous one is done */
+    NRF_RADIO->SHORTS |= RADIO_SHORTS_DISABLED_TXEN_Msk;
+    radio_cb_unregister(RADIO_EVT_DISABLED);
+    radio_cb_register(RADIO_EVT_ADDRESS, radio_address_callback);
   } else {
-    NRF_CLOCK->TASKS_HFCLKSTOP = 1;
-    /* Unregister teardown function */
-    ble_teardown_ptr = NULL;
-    xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_BLE_BASE, eSetBits, &xHigherPriorityTaskWoken);
+    radio_cb_register(RADIO_EVT_DISABLED, radio_disabled_callback);
+  }
+
+  return adv_event_run();
+}
+
+riotee_rc_t riotee_ble_adv_ext_cfg(riotee_ble_adv_ext_cfg_t *cfg) {
+  /* Extended header length and AdvMode, flags, AdvA and ADI */
+  const unsigned int aux_hdr_len = 2 + 6 + 2;
+  uint8_t *payload = ext_aux_pkt.payload;
+  unsigned int pos = 0;
+
+  if ((cfg->sid > 15) || (cfg->aux_ch > 36))
+    return RIOTEE_ERR_INVALIDARG;
+  /* The primary channels only support the 1M and the S8 Coded PHY */
+  if ((cfg->primary_phy != RIOTEE_BLE_PHY_1M) && (cfg->primary_phy != RIOTEE_BLE_PHY_CODED_S8))
+    return RIOTEE_ERR_INVALIDARG;
+  if (cfg->secondary_phy > RIOTEE_BLE_PHY_CODED_S8)
+    return RIOTEE_ERR_INVALIDARG;
+  /* Name and manufacturer specific data fields */
+  if (aux_hdr_len + 2 + cfg->name_len + 4 + cfg->data_len > RIOTEE_BLE_ADV_EXT_MAX_PAYLOAD)
+    return RIOTEE_ERR_OVERFLOW;
+
+  ext_adi = (ext_adi & 0x0FFF) | (cfg->sid << 12);
+
+  ext_aux_pkt.header.pdu_type = ADV_EXT_IND;
+  ext_aux_pkt.header.txadd = 1;
+  /* Length of extended header without the first byte, AdvMode 0: non-connectable and non-scannable */
+  payload[pos++] = aux_hdr_len - 1;
+  payload[pos++] = EXT_HDR_ADVA | EXT_HDR_ADI;
+  memcpy(&payload[pos], cfg->addr, 6);
+  pos += 6;
+  /* ADI gets updated before every advertising event */
+  pos += 2;
+
+  /* Length of name field */
+  payload[pos++] = cfg->name_len + 1;
+  /* Type for name field */
+  payload[pos++] = 0x09;
+  memcpy(&payload[pos], cfg->name, cfg->name_len);
+  pos += cfg->name_len;
+  /* MNF data length: 3B header + length of custom data */
+  payload[pos++] = 3 + cfg->data_len;
+  /* Type for MNF-specific data field */
+  payload[pos++] = 0xFF;
+  memcpy(&payload[pos], &cfg->manufacturer_id, 2);
+  pos += 2;
+
+  ext_data_offset = pos;
+  ext_data_usr = cfg->data;
+  ext_data_len = cfg->data_len;
+  ext_aux_pkt.header.len = pos + cfg->data_len;
+
+  /* Ramp-up, ADV_EXT_IND and the gap to the auxiliary packet, rounded up to the unit of the AuxPtr offset */
+  ext_spacing_us = RAMPUP_US + phy_airtime_us(cfg->primary_phy, sizeof(ext_prim_pkts[0].payload)) + EXT_MAFS_US;
+  ext_spacing_us = (ext_spacing_us + EXT_OFFSET_UNIT_US - 1) / EXT_OFFSET_UNIT_US * EXT_OFFSET_UNIT_US;
+
+  for (unsigned int i = 0; i < 3; i++) {
+    ext_prim_pck_t *pkt = &ext_prim_pkts[i];
+    /* The AUX_ADV_IND follows the last ADV_EXT_IND after one interval */
+    unsigned int aux_offset = (3 - i) * ext_spacing_us / EXT_OFFSET_UNIT_US;
+
+    pkt->header.pdu_type = ADV_EXT_IND;
+    pkt->header.len = sizeof(pkt->payload);
+    pkt->payload[0] = sizeof(pkt->payload) - 1;
+    pkt->payload[1] = EXT_HDR_ADI | EXT_HDR_AUXPTR;
+    /* AuxPtr: channel index, clock accuracy 0-50ppm, offset in units of 30us, PHY */
+    pkt->payload[4] = cfg->aux_ch | (1UL << 6);
+    pkt->payload[5] = aux_offset & 0xFF;
+    pkt->payload[6] = ((aux_offset >> 8) & 0x1F) | (phy_auxptr[cfg->secondary_phy] << 5);
+
+    ext_seq[i].ch.frequency = ch2freq(37 + i);
+    ext_seq[i].ch.datawhiteiv = 37 + i;
+    ext_seq[i].pkt = pkt;
+    ext_seq[i].phy = cfg->primary_phy;
   }
+  ext_seq[3].ch.frequency = ch2freq(cfg->aux_ch);
+  ext_seq[3].ch.datawhiteiv = cfg->aux_ch;
+  ext_seq[3].pkt = &ext_aux_pkt;
+  ext_seq[3].phy = cfg->secondary_phy;
+
+  return RIOTEE_SUCCESS;
+}
+
+riotee_rc_t riotee_ble_advertise_ext(void) {
+  /* New data ID, such that scanners do not discard the payload as duplicate */
+  ext_adi = (ext_adi & 0xF000) | ((ext_adi + 1) & 0x0FFF);
+  for (unsigned int i = 0; i < 3; i++)
+    memcpy(&ext_prim_pkts[i].payload[2], &ext_adi, 2);
+  memcpy(&ext_aux_pkt.payload[EXT_AUX_ADI_OFFSET], &ext_adi, 2);
+  memcpy(&ext_aux_pkt.payload[ext_data_offset], ext_data_usr, ext_data_len);
+  ext_seq_idx = 0;
+
+  taskENTER_CRITICAL();
+  radio_ctx_activate(&ble_ctx);
+  set_channel(&ext_seq[0].ch);
+  set_phy(ext_seq[0].phy);
+  NRF_RADIO->PACKETPTR = (uint32_t)ext_seq[0].pkt;
+
+  /* The first packet starts as soon as the HFXO is running, the remaining ones are triggered by TIMER1 */
+  NRF_TIMER1->CC[0] = ext_spacing_us;
+  NRF_TIMER1->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+  NRF_TIMER1->TASKS_CLEAR = 1;
+  NRF_PPI->FORK[18].TEP = (uint32_t)&NRF_TIMER1->TASKS_START;
+  NRF_PPI->CHENSET = (1UL << EXT_PPI_CH);
+
+  radio_cb_unregister(RADIO_EVT_DISABLED);
+  radio_cb_register(RADIO_EVT_ADDRESS, radio_ext_address_callback);
+
+  return adv_event_run();
+}
+
+riotee_rc_t riotee_ble_scan(riotee_ble_scan_cfg_t *cfg, riotee_ble_scan_result_t *res) {
+  adv_ch_cfg_t ch;
+  riotee_rc_t rc;
+
+  if ((cfg->ch != ADV_CH_37) && (cfg->ch != ADV_CH_38) && (cfg->ch != ADV_CH_39))
+    return RIOTEE_ERR_INVALIDARG;
+
+  ch.frequency = ch2freq(cfg->ch);
+  ch.datawhiteiv = cfg->ch;
+  scan_res = res;
+  scan_mnf_id = cfg->manufacturer_id;
+  scan_matched = false;
+
+  taskENTER_CRITICAL();
+  radio_ctx_activate(&ble_ctx);
+  set_channel(&ch);
+  set_phy(RIOTEE_BLE_PHY_1M);
+  NRF_RADIO->PACKETPTR = (uint32_t)&scan_pkt;
+
+  /* The radio compares the first six bytes of the payload, i.e. AdvA, and TxAdd with device address 0 */
+  if (cfg->addr != NULL) {
+    NRF_RADIO->DAB[0] = cfg->addr[0] | (cfg->addr[1] << 8) | (cfg->addr[2] << 16) | (cfg->addr[3] << 24);
+    NRF_RADIO->DAP[0] = cfg->addr[4] | (cfg->addr[5] << 8);
+    NRF_RADIO->DACNF = RADIO_DACNF_ENA0_Msk | (cfg->addr_random ? RADIO_DACNF_TXADD0_Msk : 0);
+  } else {
+    NRF_RADIO->DACNF = 0;
+  }
+  NRF_RADIO->EVENTS_DEVMATCH = 0;
+  NRF_RADIO->EVENTS_DEVMISS = 0;
+
+  /* RSSI is sampled after every address. The callbacks restart reception only after they are done with the buffer and
+   * RSSISAMPLE, such that the next packet cannot overwrite them. */
+  NRF_RADIO->SHORTS = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_ADDRESS_RSSISTART_Msk;
+
+  /* HFCLKSTARTED enables the receiver and starts TIMER1, which disables the radio at the end of the window */
+  NRF_TIMER1->SHORTS = 0;
+  NRF_TIMER1->CC[1] = cfg->window_ms * 1000;
+  NRF_TIMER1->TASKS_CLEAR = 1;
+  NRF_PPI->CH[18].TEP = (uint32_t)&NRF_RADIO->TASKS_RXEN;
+  NRF_PPI->FORK[18].TEP = (uint32_t)&NRF_TIMER1->TASKS_START;
+  NRF_PPI->CHENSET = (1UL << SCAN_PPI_CH);
+
+  radio_cb_unregister(RADIO_EVT_ADDRESS);
+  radio_cb_register(RADIO_EVT_CRCOK, radio_scan_crcok_callback);
+  radio_cb_register(RADIO_EVT_CRCERR, radio_scan_crcerr_callback);
+  radio_cb_register(RADIO_EVT_DISABLED, radio_scan_disabled_callback);
+
+  rc = adv_event_run();
+  if (rc != RIOTEE_SUCCESS)
+    return rc;
+  if (!scan_matched)
+    return RIOTEE_ERR_BLE_TIMEOUT;
+  return RIOTEE_SUCCESS;
+}
+
+static void radio_scan_crcerr_callback(void) {
+  NRF_RADIO->EVENTS_DEVMATCH = 0;
+  NRF_RADIO->EVENTS_DEVMISS = 0;
+  /* Ignored if TIMER1 has disabled the radio in the meantime */
+  NRF_RADIO->TASKS_START = 1;
+}
+
+/* Searches the advertising data for manufacturer specific data from the given manufacturer */
+static bool scan_mnf_match(const uint8_t *data, size_t len, uint16_t mnf_id) {
+  size_t pos = 0;
+
+  while (pos + 1 < len) {
+    size_t field_len = data[pos];
+    if ((field_len == 0) || (pos + 1 + field_len > len))
+      return false;
+    /* Type, followed by the two byte company ID */
+    if ((data[pos + 1] == 0xFF) && (field_len >= 3) && ((data[pos + 2] | (data[pos + 3] << 8)) == mnf_id))
+      return true;
+    pos += 1 + field_len;
+  }
+  return false;
+}
+
+/* Checks whether the received packet matches the scan filters */
+static bool scan_pkt_match(bool addr_match) {
+  riotee_ble_adv_header_t *header = &scan_pkt.header;
+
+  if ((header->pdu_type != ADV_IND) && (header->pdu_type != ADV_NONCONN_IND) && (header->pdu_type != ADV_SCAN_IND))
+    return false;
+  if ((header->len < 6) || (header->len > 6 + sizeof(scan_res->data)))
+    return false;
+  /* Hardware address filter */
+  if ((NRF_RADIO->DACNF & RADIO_DACNF_ENA0_Msk) && !addr_match)
+    return false;
+  if ((scan_mnf_id != RIOTEE_BLE_MNF_ANY) && !scan_mnf_match(&scan_pkt.payload[6], header->len - 6, scan_mnf_id))
+    return false;
+  return true;
+}
+
+/* Gets called for every packet received with a valid CRC while scanning. The radio waits in RXIDLE until the packet
+ * has been evaluated. */
+static void radio_scan_crcok_callback(void) {
+  riotee_ble_adv_header_t *header = &scan_pkt.header;
+  /* DEVMATCH and DEVMISS are cleared after every packet, such that they refer to the current one */
+  bool addr_match = (NRF_RADIO->EVENTS_DEVMATCH == 1);
+  size_t data_len;
+
+  NRF_RADIO->EVENTS_DEVMATCH = 0;
+  NRF_RADIO->EVENTS_DEVMISS = 0;
+
+  if (!scan_pkt_match(addr_match)) {
+    /* Ignored if TIMER1 has disabled the radio in the meantime */
+    NRF_RADIO->TASKS_START = 1;
+    return;
+  }
+
+  data_len = header->len - 6;
+  scan_res->pdu_type = header->pdu_type;
+  scan_res->addr_random = header->txadd;
+  memcpy(scan_res->addr, scan_pkt.payload, 6);
+  memcpy(scan_res->data, &scan_pkt.payload[6], data_len);
+  scan_res->data_len = data_len;
+  scan_res->rssi_dbm = -(int)NRF_RADIO->RSSISAMPLE;
+  scan_matched = true;
+  NRF_RADIO->TASKS_DISABLE = 1;
+}
+
+/*
+ * Gets called while a packet of a multi-channel advertising event is on air. FREQUENCY is sampled when the radio ramps
+ * up, DATAWHITEIV and PACKETPTR when the transmission starts. They can thus be loaded for the next channel before the
+ * DISABLED_TXEN short triggers it.
+ */
+static void radio_address_callback(void) {
+  /* The radio has started the current packet, so it is done with the previous one */
+  adv_draining = false;
+  if (adv_seq_idx + 1 < adv_seq_len) {
+    set_channel(&adv_seq[++adv_seq_idx]);
+    /* The packet that gets swapped out is on air until END */
+    adv_draining = adv_pending;
+    adv_swap();
+  } else {
+    /* Last channel: end the chain and wait for the radio to finish */
+    NRF_RADIO->SHORTS &= ~RADIO_SHORTS_DISABLED_TXEN_Msk;
+    radio_cb_unregister(RADIO_EVT_ADDRESS);
+    radio_cb_register(RADIO_EVT_DISABLED, radio_disabled_callback);
+  }
+}
+
+/* Same as above for extended advertising, where TIMER1 instead of a short starts the next packet */
+static void radio_ext_address_callback(void) {
+  if (ext_seq_idx + 1 < sizeof(ext_seq) / sizeof(ext_seq[0])) {
+    ext_seq_idx++;
+    set_channel(&ext_seq[ext_seq_idx].ch);
+    NRF_RADIO->PACKETPTR = (uint32_t)ext_seq[ext_seq_idx].pkt;
+    /* MODE must not change while the current packet is on air */
+    if (ext_seq[ext_seq_idx].phy != ext_seq[ext_seq_idx - 1].phy)
+      radio_cb_register(RADIO_EVT_DISABLED, radio_ext_disabled_callback);
+  } else {
+    ext_stop();
+    radio_cb_unregister(RADIO_EVT_ADDRESS);
+    radio_cb_register(RADIO_EVT_DISABLED, radio_disabled_callback);
+  }
+}
+
+/* Switches the PHY between two packets of an extended advertising event. TIMER1 enables the radio at least T_MAFS
+ * later. */
+static void radio_ext_disabled_callback(void) {
+  set_phy(ext_seq[ext_seq_idx].phy);
+  radio_cb_unregister(RADIO_EVT_DISABLED);
+}
+
+/* Gets called after the last packet of an advertising event has been transmitted and the radio has been disabled */
+static void radio_disabled_callback(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  NRF_CLOCK->TASKS_HFCLKSTOP = 1;
+  radio_cb_unregister(RADIO_EVT_DISABLED);
+  adv_running = false;
+  adv_draining = false;
+  /* A packet committed during the last channel is swapped in right away */
+  adv_swap();
+  /* Unregister teardown function */
+  ble_teardown_ptr = NULL;
+  xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_BLE_BASE, eSetBits, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/* Gets called when a scan window ends, either after a match or when TIMER1 expires */
+static void radio_scan_disabled_callback(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  NRF_CLOCK->TASKS_HFCLKSTOP = 1;
+  scan_stop();
+  radio_cb_unregister(RADIO_EVT_DISABLED);
+  /* Unregister teardown function */
+  ble_teardown_ptr = NULL;
+  xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_BLE_BASE, eSetBits, &xHigherPriorityTaskWoken);
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 void riotee_ble_init(void) {
+  radio_ctx_init(&ble_ctx);
+  radio_ctx_activate(&ble_ctx);
+
   NRF_RADIO->TXPOWER = (RADIO_TXPOWER_TXPOWER_Pos4dBm << RADIO_TXPOWER_TXPOWER_Pos);
 
   NRF_RADIO->MODE = (RADIO_MODE_MODE_Ble_1Mbit << RADIO_MODE_MODE_Pos);
@@ -190,10 +689,17 @@ void riotee_ble_init(void) {
   /* Set default shorts */
   NRF_RADIO->SHORTS = NRF_RADIO_SHORT_READY_START_MASK | NRF_RADIO_SHORT_END_DISABLE_MASK;
 
-  /* Always transmit packet from the same memory address, just replace the payload there */
-  NRF_RADIO->PACKETPTR = (uint32_t)&adv_pkt;
-
-  radio_cb_register(RADIO_EVT_DISABLED, radio_disabled_callback);
+  adv_running = false;
+  NRF_RADIO->PACKETPTR = (uint32_t)&adv_pkts[adv_active];
+
+  /* 1MHz timer that triggers the packets of an extended advertising event and ends scan windows */
+  NRF_TIMER1->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
+  NRF_TIMER1->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+  NRF_TIMER1->PRESCALER = 4;
+  NRF_PPI->CH[EXT_PPI_CH].EEP = (uint32_t)&NRF_TIMER1->EVENTS_COMPARE[0];
+  NRF_PPI->CH[EXT_PPI_CH].TEP = (uint32_t)&NRF_RADIO->TASKS_TXEN;
+  NRF_PPI->CH[SCAN_PPI_CH].EEP = (uint32_t)&NRF_TIMER1->EVENTS_COMPARE[1];
+  NRF_PPI->CH[SCAN_PPI_CH].TEP = (uint32_t)&NRF_RADIO->TASKS_DISABLE;
 
   radio_init();
 
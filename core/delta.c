@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "riotee.h"
+#include "riotee_delta.h"
+#include "riotee_stella.h"
+
+/* Maps the signed difference between two values to an unsigned integer with small magnitudes close to zero */
+static inline uint32_t zigzag(int32_t prev, int32_t value) {
+  uint32_t d = (uint32_t)value - (uint32_t)prev;
+  return (d << 1) ^ (0UL - (d >> 31));
+}
+
+static inline unsigned int varint_size(uint32_t x) {
+  return 1 + (x >= (1UL << 7)) + (x >= (1UL << 14)) + (x >= (1UL << 21)) + (x >= (1UL << 28));
+}
+
+static unsigned int varint_write(uint8_t *dst, uint32_t x) {
+  unsigned int n = 0;
+  while (x >= 0x80) {
+    dst[n++] = (x & 0x7F) | 0x80;
+    x >>= 7;
+  }
+  dst[n++] = x;
+  return n;
+}
+
+static unsigned int block_width(const uint32_t *block, unsigned int n) {
+  uint32_t acc = 0;
+  for (unsigned int i = 0; i < n; i++)
+    acc |= block[i];
+  return acc ? 32 - __builtin_clz(acc) : 0;
+}
+
+/* Number of bytes required to store a block of n deltas */
+static unsigned int block_size(const uint32_t *block, unsigned int n) {
+  if (n == 0)
+    return 0;
+  return 1 + (n * block_width(block, n) + 7) / 8;
+}
+
+static unsigned int block_write(uint8_t *dst, const uint32_t *block, unsigned int n) {
+  unsigned int width = block_width(block, n);
+  unsigned int pos = 0;
+  uint64_t acc = 0;
+  unsigned int n_acc = 0;
+
+  dst[pos++] = width;
+  for (unsigned int i = 0; i < n; i++) {
+    acc |= (uint64_t)block[i] << n_acc;
+    n_acc += width;
+    while (n_acc >= 8) {
+      dst[pos++] = acc;
+      acc >>= 8;
+      n_acc -= 8;
+    }
+  }
+  if (n_acc > 0)
+    dst[pos++] = acc;
+  return pos;
+}
+
+riotee_rc_t riotee_delta_init(riotee_delta_enc_t *enc, unsigned int n_channels, riotee_delta_mode_t mode,
+                              size_t capacity) {
+  if ((n_channels == 0) || (n_channels > RIOTEE_DELTA_MAX_CHANNELS))
+    return RIOTEE_ERR_INVALIDARG;
+  if ((capacity <= RIOTEE_DELTA_HEADER_SIZE) || (capacity > RIOTEE_DELTA_MAX_SIZE))
+    return RIOTEE_ERR_INVALIDARG;
+  if ((mode != RIOTEE_DELTA_MODE_VARINT) && (mode != RIOTEE_DELTA_MODE_BITPACK))
+    return RIOTEE_ERR_INVALIDARG;
+
+  enc->n_channels = n_channels;
+  enc->mode = mode;
+  enc->capacity = capacity;
+  riotee_delta_reset(enc);
+  return RIOTEE_SUCCESS;
+}
+
+void riotee_delta_reset(riotee_delta_enc_t *enc) {
+  enc->n_frames = 0;
+  enc->n_block = 0;
+  enc->len = RIOTEE_DELTA_HEADER_SIZE;
+}
+
+/* The first frame of a packet and all frames in varint mode */
+static riotee_rc_t push_varint(riotee_delta_enc_t *enc, const int32_t *values) {
+  unsigned int size = 0;
+  unsigned int pos = enc->len;
+
+  for (unsigned int i = 0; i < enc->n_channels; i++)
+    size += varint_size(zigzag(enc->n_frames ? enc->last[i] : 0, values[i]));
+  if (pos + size > enc->capacity)
+    return RIOTEE_ERR_OVERFLOW;
+
+  for (unsigned int i = 0; i < enc->n_channels; i++)
+    pos += varint_write(&enc->buf[pos], zigzag(enc->n_frames ? enc->last[i] : 0, values[i]));
+  enc->len = pos;
+  return RIOTEE_SUCCESS;
+}
+
+static riotee_rc_t push_bitpack(riotee_delta_enc_t *enc, const int32_t *values) {
+  uint32_t block[RIOTEE_DELTA_BLOCK_SIZE];
+  unsigned int n_block = enc->n_block;
+  unsigned int pos = enc->len;
+
+  /* Work on a copy of the pending block so that the encoder is unchanged if the frame does not fit. Completed blocks
+   * are written behind enc->len, which only gets advanced on success. */
+  memcpy(block, enc->block, sizeof(block));
+  for (unsigned int i = 0; i < enc->n_channels; i++) {
+    block[n_block++] = zigzag(enc->last[i], values[i]);
+    if (n_block == RIOTEE_DELTA_BLOCK_SIZE) {
+      if (pos + block_size(block, n_block) > enc->capacity)
+        return RIOTEE_ERR_OVERFLOW;
+      pos += block_write(&enc->buf[pos], block, n_block);
+      n_block = 0;
+    }
+  }
+  if (pos + block_size(block, n_block) > enc->capacity)
+    return RIOTEE_ERR_OVERFLOW;
+
+  memcpy(enc->block, block, sizeof(block));
+  enc->n_block = n_block;
+  enc->len = pos;
+  return RIOTEE_SUCCESS;
+}
+
+riotee_rc_t riotee_delta_push(riotee_delta_enc_t *enc, const int32_t *values) {
+  riotee_rc_t rc;
+
+  if (enc->n_frames == UINT16_MAX)
+    return RIOTEE_ERR_OVERFLOW;
+
+  if ((enc->n_frames == 0) || (enc->mode == RIOTEE_DELTA_MODE_VARINT))
+    rc = push_varint(enc, values);
+  else
+    rc = push_bitpack(enc, values);
+  if (rc != RIOTEE_SUCCESS)
+    return rc;
+
+  memcpy(enc->last, values, enc->n_channels * sizeof(int32_t));
+  enc->n_frames++;
+  return RIOTEE_SUCCESS;
+}
+
+size_t riotee_delta_finish(riotee_delta_enc_t *enc) {
+  size_t size = enc->len;
+
+  if (enc->n_frames == 0)
+    return 0;
+
+  enc->buf[0] = (enc->mode << 4) | enc->n_channels;
+  enc->buf[1] = enc->n_frames & 0xFF;
+  enc->buf[2] = enc->n_frames >> 8;
+
+  if (enc->n_block > 0)
+    size += block_write(&enc->buf[size], enc->block, enc->n_block);
+  return size;
+}
+
+riotee_rc_t riotee_delta_stella_send(riotee_delta_enc_t *enc) {
+  riotee_rc_t rc;
+  size_t size = riotee_delta_finish(enc);
+
+  if (size == 0)
+    return RIOTEE_SUCCESS;
+
+  rc = riotee_stella_send(enc->buf, size);
+  if (rc == RIOTEE_SUCCESS)
+    riotee_delta_reset(enc);
+  return rc;
+}
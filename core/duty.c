@@ -0,0 +1,108 @@
+#include "riotee.h"
+#include "riotee_duty.h"
+#include "riotee_energy.h"
+#include "riotee_thresholds.h"
+#include "riotee_timing.h"
+#include "runtime.h"
+
+/* Weight of older measurements in the smoothed power and period */
+#define SMOOTHING 4
+/* Period correction per unit of state-of-charge error */
+#define SOC_GAIN 2.0f
+/* Limits of the period correction */
+#define CORR_MIN 0.25f
+#define CORR_MAX 4.0f
+
+riotee_rc_t riotee_duty_init(riotee_duty_t *duty, const riotee_duty_cfg_t *cfg) {
+  if ((cfg->min_period_ms == 0) || (cfg->min_period_ms > cfg->max_period_ms))
+    return RIOTEE_ERR_INVALIDARG;
+  if ((cfg->target_soc < 0.0f) || (cfg->target_soc > 1.0f))
+    return RIOTEE_ERR_INVALIDARG;
+
+  duty->cfg = *cfg;
+  duty->period_ms = cfg->max_period_ms;
+  duty->has_p_in = false;
+  duty->has_wake = false;
+  return RIOTEE_SUCCESS;
+}
+
+/* Energy between the 'low' and the 'high' threshold */
+static float energy_full(void) {
+  float v_low = riotee_thresholds_low_get();
+  float v_high = riotee_thresholds_high_get();
+  return 0.5f * riotee_energy_capacitance_get() * (v_high * v_high - v_low * v_low);
+}
+
+static void period_update(riotee_duty_t *duty, float e_now) {
+  float e_full = energy_full();
+  float soc = (e_full > 0.0f) ? e_now / e_full : 0.0f;
+  float period, corr;
+
+  /* A full capacitor cannot store more energy. The gain while sleeping is then no measure of the harvested power and
+   * any time spent sleeping wastes energy, so run as often as allowed. */
+  if ((soc >= 1.0f) || (duty->has_wake && (duty->e_wake >= e_full))) {
+    duty->period_ms = duty->cfg.min_period_ms;
+    return;
+  }
+
+  /* Energy-neutral period: time the harvester needs to replace the energy used since the previous wait */
+  if (duty->has_wake && duty->has_p_in && (duty->p_in > 0.0f) && (duty->e_wake > e_now))
+    period = (duty->e_wake - e_now) / duty->p_in * 1000.0f;
+  else if (duty->has_wake && (duty->e_wake <= e_now))
+    /* Harvested more than consumed during the active part */
+    period = duty->cfg.min_period_ms;
+  else
+    period = duty->cfg.max_period_ms;
+
+  corr = 1.0f + SOC_GAIN * (duty->cfg.target_soc - soc);
+  corr = (corr < CORR_MIN) ? CORR_MIN : ((corr > CORR_MAX) ? CORR_MAX : corr);
+  period = ((SMOOTHING - 1) * (float)duty->period_ms + period * corr) / SMOOTHING;
+
+  if (period < duty->cfg.min_period_ms)
+    duty->period_ms = duty->cfg.min_period_ms;
+  else if (period > duty->cfg.max_period_ms)
+    duty->period_ms = duty->cfg.max_period_ms;
+  else
+    duty->period_ms = period;
+}
+
+riotee_rc_t riotee_duty_wait(riotee_duty_t *duty) {
+  float e_sleep = riotee_energy_available();
+  float e_wake, p;
+  uint64_t t_sleep, t_wake;
+  riotee_rc_t rc;
+
+  period_update(duty, e_sleep);
+
+  /* Use the tick counter directly to leave the reset indication of riotee_timing_now() to the application */
+  t_sleep = timing_ticks();
+  if ((rc = riotee_sleep_ms(duty->period_ms)) != RIOTEE_SUCCESS) {
+    duty->has_wake = false;
+    return rc;
+  }
+  e_wake = riotee_energy_available();
+  t_wake = timing_ticks();
+  if (t_wake <= t_sleep) {
+    duty->has_wake = false;
+    return RIOTEE_SUCCESS;
+  }
+
+  duty->e_wake = e_wake;
+  duty->has_wake = true;
+
+  /* Below the 'low' threshold the gauge reads 0 and the gain while sleeping is unknown. On a full capacitor, the gain
+   * is limited by the capacity and says nothing about the harvested power. */
+  if (e_wake >= energy_full())
+    return RIOTEE_SUCCESS;
+  if (e_sleep > 0.0f)
+    p = (e_wake - e_sleep) * 32768.0f / (t_wake - t_sleep);
+  else if (riotee_energy_harvest_power(&p) != RIOTEE_SUCCESS)
+    return RIOTEE_SUCCESS;
+
+  if (duty->has_p_in)
+    duty->p_in += (p - duty->p_in) / SMOOTHING;
+  else
+    duty->p_in = p;
+  duty->has_p_in = true;
+  return RIOTEE_SUCCESS;
+}
@@ -0,0 +1,176 @@
+#include <stddef.h>
+
+#include "riotee.h"
+#include "riotee_adc.h"
+#include "riotee_energy.h"
+#include "riotee_thresholds.h"
+#include "riotee_timing.h"
+#include "runtime.h"
+
+/* riotee_adc_read() uses 1/4 gain and VDD/4 reference, i.e. the full scale is the 2V supply */
+#define VDD 2.0f
+
+/* Number of averaged samples for slope measurements */
+#define N_AVG 16
+/* Maximum duration of each phase of the characterization in ticks */
+#define PHASE_TICKS (RIOTEE_ENERGY_CHAR_MAX_MS * 32768UL / 2000)
+/* The load phase ends after this voltage drop ... */
+#define LOAD_DROP_V 0.1f
+/* ... or when the capacitor voltage gets this close to the 'low' threshold */
+#define LOAD_MARGIN_V 0.2f
+/* Time the CPU spins between two checks of the capacitor voltage in the load phase */
+#define LOAD_CHUNK_US 250
+
+static float capacitance = RIOTEE_ENERGY_CAPACITANCE;
+static float i_idle = 0.0f;
+/* Smoothed harvest power in watts. Negative if there is no estimate yet. */
+static float p_harvest = -1.0f;
+
+typedef struct {
+  uint32_t signature;
+  riotee_energy_char_t res;
+} energy_rec_t;
+
+void riotee_energy_capacitance_set(float farads) {
+  capacitance = farads;
+}
+
+float riotee_energy_capacitance_get(void) {
+  return capacitance;
+}
+
+float riotee_energy_vcap(void) {
+  int16_t result = riotee_adc_read(RIOTEE_ADC_INPUT_VCAP);
+  return riotee_adc_vadc2vcap(result * (VDD / (1 << 12)));
+}
+
+float riotee_energy_idle_current_get(void) {
+  return i_idle;
+}
+
+static float vcap_mean(void) {
+  int32_t sum = 0;
+  for (unsigned int i = 0; i < N_AVG; i++)
+    sum += riotee_adc_read(RIOTEE_ADC_INPUT_VCAP);
+  return riotee_adc_vadc2vcap(sum * (VDD / (1 << 12) / N_AVG));
+}
+
+riotee_rc_t riotee_energy_init(void) {
+  energy_rec_t rec;
+
+  if (runtime_meta_read(NVM_META_ENERGY, &rec, sizeof(rec)) != 0)
+    return RIOTEE_ERR_GENERIC;
+  if (rec.signature != NVM_META_SIG)
+    return RIOTEE_ERR_GENERIC;
+
+  capacitance = rec.res.capacitance;
+  i_idle = rec.res.i_idle;
+  return RIOTEE_SUCCESS;
+}
+
+riotee_rc_t riotee_energy_characterize(riotee_energy_char_t *res) {
+  energy_rec_t rec;
+  uint64_t t0, t1, t2, t3;
+  float v0, v1, v2, v3, v_stop;
+  float slope_idle, slope_load, diff;
+  unsigned int n_reset, n_suspend;
+  riotee_rc_t rc;
+
+  if ((rc = riotee_wait_cap_charged()) != RIOTEE_SUCCESS)
+    return rc;
+
+  /* Use the tick counter directly to leave the reset indication of riotee_timing_now() to the application */
+  n_reset = runtime_stats.n_reset;
+  /* A suspension at the 'low' threshold would be part of the measured time */
+  n_suspend = runtime_stats.n_suspend;
+
+  /* Idle phase */
+  t0 = timing_ticks();
+  v0 = vcap_mean();
+  if ((rc = riotee_sleep_ticks(PHASE_TICKS)) != RIOTEE_SUCCESS)
+    return rc;
+  v1 = vcap_mean();
+  t1 = timing_ticks();
+
+  if (runtime_stats.n_suspend != n_suspend)
+    return RIOTEE_ERR_TEARDOWN;
+
+  /* Load phase. The CPU spins and only takes a single ADC sample per chunk, so the load is dominated by the CPU. */
+  v_stop = riotee_thresholds_low_get() + LOAD_MARGIN_V;
+  if (v1 - LOAD_DROP_V > v_stop)
+    v_stop = v1 - LOAD_DROP_V;
+  t2 = t1;
+  v2 = v1;
+  do {
+    riotee_delay_us(LOAD_CHUNK_US);
+    t3 = timing_ticks();
+  } while ((riotee_energy_vcap() > v_stop) && (t3 - t2 < PHASE_TICKS));
+  v3 = vcap_mean();
+  t3 = timing_ticks();
+
+  if (runtime_stats.n_reset != n_reset)
+    return RIOTEE_ERR_RESET;
+  if (runtime_stats.n_suspend != n_suspend)
+    return RIOTEE_ERR_TEARDOWN;
+
+  if ((t1 == t0) || (t3 == t2))
+    return RIOTEE_ERR_GENERIC;
+  slope_idle = (v1 - v0) * 32768.0f / (t1 - t0);
+  slope_load = (v3 - v2) * 32768.0f / (t3 - t2);
+
+  /* The load draws P = C * V * (slope_idle - slope_load) on top of the idle current */
+  diff = slope_idle - slope_load;
+  if (diff <= 0.0f)
+    return RIOTEE_ERR_GENERIC;
+  rec.res.capacitance = RIOTEE_ENERGY_LOAD_POWER / (0.5f * (v2 + v3) * diff);
+  rec.res.i_idle = -rec.res.capacitance * slope_idle;
+
+  capacitance = rec.res.capacitance;
+  i_idle = rec.res.i_idle;
+  if (res != NULL)
+    *res = rec.res;
+
+  rec.signature = NVM_META_SIG;
+  if (runtime_meta_write(NVM_META_ENERGY, &rec, sizeof(rec)) != 0)
+    return RIOTEE_ERR_GENERIC;
+  return RIOTEE_SUCCESS;
+}
+
+void energy_recharged(uint64_t ticks) {
+  float v_low = riotee_thresholds_low_get();
+  float v_high = riotee_thresholds_high_get();
+  float p;
+
+  if ((ticks == 0) || (v_high <= v_low))
+    return;
+
+  /* Energy stored between the thresholds over the recharge time, plus what the device consumed while sleeping */
+  p = 0.5f * capacitance * (v_high * v_high - v_low * v_low) * 32768.0f / ticks;
+  if (i_idle > 0.0f)
+    p += i_idle * 0.5f * (v_low + v_high);
+
+  if (p_harvest < 0.0f)
+    p_harvest = p;
+  else
+    p_harvest += (p - p_harvest) / RIOTEE_ENERGY_HARVEST_SMOOTHING;
+}
+
+riotee_rc_t riotee_energy_harvest_power(float *dst) {
+  if (p_harvest < 0.0f)
+    return RIOTEE_ERR_GENERIC;
+  *dst = p_harvest;
+  return RIOTEE_SUCCESS;
+}
+
+float riotee_energy_available(void) {
+  float v_cap = riotee_energy_vcap();
+  float v_low = riotee_thresholds_low_get();
+
+  if (v_cap <= v_low)
+    return 0.0f;
+  return 0.5f * capacitance * (v_cap * v_cap - v_low * v_low);
+}
+
+bool riotee_energy_can_afford(float cost) {
+  return riotee_energy_available() >= cost;
+}
@@ -0,0 +1,83 @@
+#include <math.h>
+#include <string.h>
+
+#include "riotee.h"
+#include "riotee_filter.h"
+#include "runtime.h"
+
+riotee_rc_t riotee_filter_init(riotee_filter_t *filter, const riotee_filter_cfg_t *cfg, unsigned int n_channels) {
+  if ((n_channels == 0) || (n_channels > RIOTEE_FILTER_MAX_CHANNELS))
+    return RIOTEE_ERR_INVALIDARG;
+
+  memset(filter, 0, sizeof(riotee_filter_t));
+  memcpy(filter->cfg, cfg, n_channels * sizeof(riotee_filter_cfg_t));
+  filter->n_channels = n_channels;
+  return RIOTEE_SUCCESS;
+}
+
+/* Checks the triggers of one channel. dt_ms is negative if the time since the previous reading is unknown. */
+static bool triggered(riotee_filter_t *filter, unsigned int ch, float value, int32_t dt_ms) {
+  riotee_filter_cfg_t *cfg = &filter->cfg[ch];
+  float diff;
+
+  if (!(filter->valid & (1 << ch)))
+    return true;
+
+  if ((cfg->max_silence_ms > 0) && (filter->silence_ms[ch] >= cfg->max_silence_ms))
+    return true;
+
+  diff = fabsf(value - filter->reported[ch]);
+  if ((cfg->abs_delta > 0.0f) && (diff > cfg->abs_delta))
+    return true;
+  if ((cfg->rel_delta > 0.0f) && (diff > cfg->rel_delta * fabsf(filter->reported[ch])))
+    return true;
+
+  if ((cfg->max_rate > 0.0f) && (dt_ms >= 0) && filter->has_last) {
+    /* Compare without dividing so that two readings at the same time do not cause trouble */
+    if (fabsf(value - filter->last[ch]) * 1000.0f > cfg->max_rate * dt_ms)
+      return true;
+  }
+  return false;
+}
+
+uint32_t riotee_filter_update(riotee_filter_t *filter, const float *values) {
+  uint64_t now;
+  int32_t dt_ms = -1;
+  uint32_t mask = 0;
+  bool reset;
+
+  /* Use the tick counter directly to leave the reset indication of riotee_timing_now() to the application */
+  now = timing_ticks();
+  reset = filter->has_last && (filter->n_reset != runtime_stats.n_reset);
+  if (filter->has_last && !reset && (now >= filter->t_last)) {
+    uint64_t dt = ((now - filter->t_last) * 1000) >> 15;
+    dt_ms = (dt > INT32_MAX) ? INT32_MAX : dt;
+  }
+
+  for (unsigned int i = 0; i < filter->n_channels; i++) {
+    /* The time without power is unknown. Count it as expired silence, otherwise frequent power failures would
+     * suppress the heartbeat forever. */
+    if (reset)
+      filter->silence_ms[i] = UINT32_MAX;
+    else if (dt_ms > 0)
+      filter->silence_ms[i] = (filter->silence_ms[i] > UINT32_MAX - dt_ms) ? UINT32_MAX : filter->silence_ms[i] + dt_ms;
+
+    if (triggered(filter, i, values[i], dt_ms))
+      mask |= (1 << i);
+    filter->last[i] = values[i];
+  }
+  filter->t_last = now;
+  filter->n_reset = runtime_stats.n_reset;
+  filter->has_last = true;
+  return mask;
+}
+
+void riotee_filter_commit(riotee_filter_t *filter, uint32_t mask) {
+  for (unsigned int i = 0; i < filter->n_channels; i++) {
+    if (!(mask & (1 << i)))
+      continue;
+    filter->reported[i] = filter->last[i];
+    filter->silence_ms[i] = 0;
+    filter->valid |= (1 << i);
+  }
+}
@@ -49,6 +49,7 @@
 #define RIOTEE_RC_BASE 0x00000000
 #define RIOTEE_RC_STELLA_BASE 0x01000000
 #define RIOTEE_RC_I2C_BASE 0x02000000
+#define RIOTEE_RC_BLE_BASE 0x03000000
 
 /**
  * @defgroup riotee Riotee basics
@@ -6,6 +6,7 @@
 #ifndef __RIOTEE_ADC_H_
 #define __RIOTEE_ADC_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include "riotee.h"
 
@@ -108,6 +109,17 @@ typedef enum {
   RIOTEE_ADC_RES_VDD1_2 = 3UL,
 } riotee_adc_res_t;
 
+typedef enum {
+  /** RTC0 starts each sample and the CPU handles every sample in an interrupt. */
+  RIOTEE_ADC_PACING_RTC = 0UL,
+  /**
+   * The SAADC or TIMER3 starts the samples and the whole buffer is filled via DMA with a single interrupt at the end.
+   * The SAADC internal timer is used for intervals up to 4 ticks (8kHz and above) without oversampling, TIMER3
+   * otherwise.
+   */
+  RIOTEE_ADC_PACING_HW = 1UL,
+} riotee_adc_pacing_t;
+
 typedef struct {
   /** Gain of ADC pre-amplifier. */
   riotee_adc_gain_t gain;
@@ -127,16 +139,82 @@ typedef struct {
   riotee_adc_oversample_t oversampling;
   /** Number of samples to be taken. */
   unsigned int n_samples;
-  /**  Sample interval in ticks on a 32kHz clock. */
+  /**  Sample interval in ticks on a 32kHz clock. At most 8796093 (~268s) with hardware pacing. */
   unsigned int sample_interval_ticks32;
+  /** How samples are triggered. Defaults to RIOTEE_ADC_PACING_RTC. */
+  riotee_adc_pacing_t pacing;
 } riotee_adc_cfg_t;
 
+/** Maximum number of channels in scan mode. */
+#define RIOTEE_ADC_MAX_CHANNELS 8
+
+/** Configuration of one channel in scan mode. */
+typedef struct {
+  /** Gain of ADC pre-amplifier. */
+  riotee_adc_gain_t gain;
+  /** ADC reference. */
+  riotee_adc_reference_t reference;
+  /** Acquisition time. */
+  riotee_adc_acqtime_t acq_time;
+  /** ADC positive input. */
+  riotee_adc_input_t input_pos;
+  /** ADC negative input. */
+  riotee_adc_input_t input_neg;
+  /** Positive input resistor config. */
+  riotee_adc_res_t res_pos;
+  /** Negative input resistor config. */
+  riotee_adc_res_t res_neg;
+} riotee_adc_ch_cfg_t;
+
+typedef struct {
+  /** Configuration of each channel in the order of conversion. */
+  riotee_adc_ch_cfg_t *channels;
+  /** Number of channels. Between 1 and RIOTEE_ADC_MAX_CHANNELS. */
+  unsigned int n_channels;
+  /** Oversampling factor applied to all channels. */
+  riotee_adc_oversample_t oversampling;
+  /** Number of times all channels are sampled. */
+  unsigned int n_scans;
+  /** Interval between scans in ticks on a 32kHz clock. At most 8796093 (~268s). */
+  unsigned int sample_interval_ticks32;
+} riotee_adc_scan_cfg_t;
+
+typedef struct {
+  /** Analog input to watch, RIOTEE_ADC_INPUT_A0 or RIOTEE_ADC_INPUT_A1. */
+  riotee_adc_input_t input;
+  /** Lower limit as 12-bit value w.r.t. the supply voltage like the result of riotee_adc_read(). */
+  int16_t limit_low;
+  /** Upper limit as 12-bit value w.r.t. the supply voltage like the result of riotee_adc_read(). */
+  int16_t limit_high;
+  /** Sample interval in ticks on a 32kHz clock. */
+  unsigned int sample_interval_ticks32;
+} riotee_adc_watch_cfg_t;
+
+/**
+ * @brief Callback for a completed block while streaming. Gets called from interrupt context.
+ *
+ * @param block Buffer holding the samples of the block.
+ * @param n_samples Number of samples in the block.
+ */
+typedef void (*riotee_adc_block_cb_t)(int16_t *block, unsigned int n_samples);
+
 /**
  * @brief Initializes ADC. Must be called once after reset before ADC can be used.
  *
+ * Measures the offset of the ADC if there is no calibration yet, after every 64 resets or if the temperature has
+ * changed by more than 5 degrees since the last calibration. Otherwise reuses the stored calibration.
  */
 void riotee_adc_init(void);
 
+/**
+ * @brief Measures the offset of the ADC.
+ *
+ * The offset is stored with the checkpoint and subtracted by riotee_adc_read(), riotee_adc_adc2vadc() and the batch
+ * conversion functions. Samples in buffers from riotee_adc_sample(), riotee_adc_scan() and streaming are raw values.
+ * riotee_adc_init() calls this automatically when necessary.
+ */
+void riotee_adc_calibrate(void);
+
 /**
  * @brief Reads multiple samples from the ADC.
  *
@@ -149,9 +227,97 @@ void riotee_adc_init(void);
  * @retval RIOTEE_SUCCESS       Sampling completed.
  * @retval RIOTEE_ERR_RESET    Reset occured while sampling.
  * @retval RIOTEE_ERR_TEARDOWN Teardown occured while sampling.
+ * @retval RIOTEE_ERR_INVALIDARG More than 32767 samples or zero interval with hardware pacing.
  */
 riotee_rc_t riotee_adc_sample(int16_t *dst, riotee_adc_cfg_t *cfg);
 
+/**
+ * @brief Samples multiple channels in one conversion sequence.
+ *
+ * Each scan converts all channels back to back. The results are interleaved in dst, i.e. the sample of channel c in
+ * scan i is stored at dst[i * n_channels + c]. Scans are paced by hardware and the CPU is woken up once at the end.
+ * Blocks until all scans are done or until the operation is aborted due to low energy.
+ *
+ * @param dst Buffer with space for n_channels * n_scans samples. At most 32767.
+ * @param cfg Channel and sampling configuration.
+ *
+ * @retval RIOTEE_SUCCESS        Sampling completed.
+ * @retval RIOTEE_ERR_RESET      Reset occured while sampling.
+ * @retval RIOTEE_ERR_TEARDOWN   Teardown occured while sampling.
+ * @retval RIOTEE_ERR_INVALIDARG Number of channels or samples out of range.
+ */
+riotee_rc_t riotee_adc_scan(int16_t *dst, riotee_adc_scan_cfg_t *cfg);
+
+/**
+ * @brief Splits interleaved samples from riotee_adc_scan() into one array per channel.
+ *
+ * @param dst Array of n_channels pointers to buffers with space for n_scans samples each.
+ * @param src Interleaved samples.
+ * @param n_channels Number of channels.
+ * @param n_scans Number of scans.
+ */
+void riotee_adc_deinterleave(int16_t **dst, const int16_t *src, unsigned int n_channels, unsigned int n_scans);
+
+/**
+ * @brief Starts continuous sampling into two alternating buffers.
+ *
+ * The ADC fills one buffer while the application processes the other one. Samples are paced by hardware like with
+ * RIOTEE_ADC_PACING_HW and there is no gap between blocks. The n_samples and pacing fields of the configuration are
+ * ignored. Returns immediately. Fetch completed blocks with riotee_adc_stream_wait().
+ *
+ * @param cfg ADC and sampling configuration.
+ * @param buf_a First buffer with space for block_size samples.
+ * @param buf_b Second buffer with space for block_size samples.
+ * @param block_size Number of samples per block. At most 32767.
+ * @param cb Optional callback for every completed block or NULL.
+ *
+ * @retval RIOTEE_SUCCESS        Streaming started.
+ * @retval RIOTEE_ERR_INVALIDARG Block size or sample interval out of range.
+ * @retval RIOTEE_ERR_GENERIC    Streaming is already active.
+ */
+riotee_rc_t riotee_adc_stream_start(riotee_adc_cfg_t *cfg, int16_t *buf_a, int16_t *buf_b, unsigned int block_size,
+                                    riotee_adc_block_cb_t cb);
+
+/**
+ * @brief Waits for the next completed block.
+ *
+ * The block stays valid until the ADC has filled the other buffer, i.e. for one block period. If the application
+ * falls behind, only the latest block is returned. Completed blocks only wake up this function, so other blocking
+ * calls like riotee_sleep_ms() can be used while streaming.
+ *
+ * @param block Pointer where the address of the completed block gets stored.
+ *
+ * @retval RIOTEE_SUCCESS      Block completed.
+ * @retval RIOTEE_ERR_OVERFLOW Block completed, but at least one earlier block was lost.
+ * @retval RIOTEE_ERR_RESET    Reset occured while waiting. Streaming has stopped.
+ * @retval RIOTEE_ERR_TEARDOWN Teardown occured while waiting. Streaming has stopped.
+ * @retval RIOTEE_ERR_GENERIC  Streaming is not active.
+ */
+riotee_rc_t riotee_adc_stream_wait(int16_t **block);
+
+/**
+ * @brief Stops streaming.
+ *
+ */
+void riotee_adc_stream_stop(void);
+
+/**
+ * @brief Waits until an analog input leaves the range between two limits.
+ *
+ * RTC2 periodically triggers a sample via PPI and the ADC compares it to the limits in hardware. The CPU sleeps until
+ * a sample is at or below the lower limit or at or above the upper limit. Returns immediately if the input is already
+ * outside the range. Blocks until a limit is crossed or until the operation is aborted due to low energy.
+ *
+ * @param cfg Input, limits and sample interval.
+ * @param value Pointer where the sample that crossed a limit gets stored or NULL.
+ *
+ * @retval RIOTEE_SUCCESS        A limit was crossed.
+ * @retval RIOTEE_ERR_RESET      Reset occured while waiting.
+ * @retval RIOTEE_ERR_TEARDOWN   Teardown occured while waiting.
+ * @retval RIOTEE_ERR_INVALIDARG Sample interval out of range or lower limit above upper limit.
+ */
+riotee_rc_t riotee_adc_watch(riotee_adc_watch_cfg_t *cfg, int16_t *value);
+
 /**
  * @brief Reads a sample from the ADC.
  *
@@ -172,6 +338,68 @@ int16_t riotee_adc_read(riotee_adc_input_t in);
  */
 float riotee_adc_adc2vadc(int16_t adc, riotee_adc_cfg_t *cfg);
 
+/**
+ * @brief Precomputed factors for converting many samples taken with the same configuration.
+ *
+ * The fixed-point formats express the voltage as a fraction of full_scale_v, e.g. a Q15 value of 16384 corresponds to
+ * full_scale_v / 2.
+ */
+typedef struct {
+  /** Volts per LSB. */
+  float lsb_v;
+  /** Offset of the ADC in LSB from the calibration. */
+  float offset;
+  /** Q15 conversion: (sample * mul15 + bias15) >> shift15. */
+  int32_t bias15;
+  int16_t mul15;
+  uint8_t shift15;
+  /** Q31 conversion: (sample * mul31 + bias31) >> shift31. */
+  uint8_t shift31;
+  int32_t mul31;
+  int64_t bias31;
+} riotee_adc_scale_t;
+
+/**
+ * @brief Precomputes the factors for converting samples to voltages.
+ *
+ * @param scale Pointer where the factors get stored.
+ * @param cfg ADC configuration that was used for taking the samples.
+ * @param full_scale_v Voltage that corresponds to 1.0 in Q15 and Q31 format. Larger voltages saturate.
+ */
+void riotee_adc_scale_init(riotee_adc_scale_t *scale, riotee_adc_cfg_t *cfg, float full_scale_v);
+
+/**
+ * @brief Converts samples to voltages in volts.
+ *
+ * @param dst Buffer for n voltages.
+ * @param src n samples.
+ * @param n Number of samples.
+ * @param scale Factors from riotee_adc_scale_init().
+ */
+void riotee_adc_conv_f32(float *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale);
+
+/**
+ * @brief Converts samples to voltages in Q15 format relative to the full scale voltage.
+ *
+ * Uses the DSP instructions of the Cortex-M4 to process two samples at a time. dst may be the same buffer as src.
+ *
+ * @param dst Buffer for n voltages.
+ * @param src n samples.
+ * @param n Number of samples.
+ * @param scale Factors from riotee_adc_scale_init().
+ */
+void riotee_adc_conv_q15(int16_t *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale);
+
+/**
+ * @brief Converts samples to voltages in Q31 format relative to the full scale voltage.
+ *
+ * @param dst Buffer for n voltages.
+ * @param src n samples.
+ * @param n Number of samples.
+ * @param scale Factors from riotee_adc_scale_init().
+ */
+void riotee_adc_conv_q31(int32_t *dst, const int16_t *src, size_t n, const riotee_adc_scale_t *scale);
+
 /**
  * @brief Converts ADC input voltage to capacitor voltage based on amplifier gain.
  *
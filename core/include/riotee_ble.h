@@ -5,6 +5,7 @@
 #ifndef __RIOTEE_BLE_H__
 #define __RIOTEE_BLE_H__
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -31,8 +32,22 @@ typedef enum {
   CONNECT_REQ = 5,
   /** Scannable undirected advertisement. */
   ADV_SCAN_IND = 6,
+  /** Extended advertisement. ADV_EXT_IND on the primary, AUX_ADV_IND on the secondary channels. */
+  ADV_EXT_IND = 7,
 } riotee_adv_pdu_type_t;
 
+/** Physical layer used for transmitting packets. */
+typedef enum {
+  /** 1Mbit/s, required for legacy advertising. */
+  RIOTEE_BLE_PHY_1M = 0,
+  /** 2Mbit/s, half the air time of 1M at reduced range. */
+  RIOTEE_BLE_PHY_2M = 1,
+  /** Coded 500kbit/s with two symbols per bit. */
+  RIOTEE_BLE_PHY_CODED_S2 = 2,
+  /** Coded 125kbit/s with eight symbols per bit. Longest range at eight times the air time of 1M. */
+  RIOTEE_BLE_PHY_CODED_S8 = 3,
+} riotee_ble_phy_t;
+
 typedef enum { ADV_CH_37 = 37, ADV_CH_38 = 38, ADV_CH_39 = 39, ADV_CH_ALL = 255 } riotee_adv_ch_t;
 
 typedef struct {
@@ -66,7 +81,8 @@ typedef struct {
   const char *name;
   /** Size of 'name' in bytes. */
   size_t name_len;
-  /** Pointer to custom payload data. */
+  /** Pointer to custom payload data that is copied into the packet before advertising. NULL if the application writes
+   * the data directly with riotee_ble_adv_data(). */
   void *data;
   /** Size of 'data' in bytes. */
   size_t data_len;
@@ -74,6 +90,75 @@ typedef struct {
   uint16_t manufacturer_id;
 } riotee_ble_adv_cfg_t;
 
+/** Maximum size of an extended advertising PDU payload. */
+#define RIOTEE_BLE_ADV_EXT_MAX_PAYLOAD 255
+
+/**
+ * @brief Extended advertising PDU. The extended header and the advertising data share the payload.
+ *
+ */
+typedef struct {
+  riotee_ble_adv_header_t header;
+  uint8_t payload[RIOTEE_BLE_ADV_EXT_MAX_PAYLOAD];
+} __attribute__((__packed__)) riotee_adv_ext_pck_t;
+
+/** BLE extended advertising configuration. */
+typedef struct {
+  /** Pointer to advertising address. */
+  const uint8_t *addr;
+  /** Advertising name of the device. */
+  const char *name;
+  /** Size of 'name' in bytes. */
+  size_t name_len;
+  /** Pointer to custom payload data that is copied into the auxiliary packet before advertising. */
+  void *data;
+  /** Size of 'data' in bytes. */
+  size_t data_len;
+  /** Manufacturer ID. */
+  uint16_t manufacturer_id;
+  /** Advertising set ID (0-15) that lets scanners tell different kinds of advertisements from the same device apart. */
+  uint8_t sid;
+  /** Secondary advertising channel (0-36) carrying the auxiliary packet. */
+  uint8_t aux_ch;
+  /** PHY of the ADV_EXT_IND packets. Must be RIOTEE_BLE_PHY_1M or RIOTEE_BLE_PHY_CODED_S8. */
+  riotee_ble_phy_t primary_phy;
+  /** PHY of the AUX_ADV_IND packet. */
+  riotee_ble_phy_t secondary_phy;
+} riotee_ble_adv_ext_cfg_t;
+
+/** Accept advertisements with any or without manufacturer specific data when scanning. */
+#define RIOTEE_BLE_MNF_ANY 0xFFFF
+
+/** BLE scan configuration. */
+typedef struct {
+  /** Advertising channel to listen on. Must not be ADV_CH_ALL. */
+  riotee_adv_ch_t ch;
+  /** Maximum time to listen in milliseconds. */
+  unsigned int window_ms;
+  /** Only accept advertisements from this address, matched by the radio hardware. NULL accepts all addresses. */
+  const uint8_t *addr;
+  /** Whether 'addr' is a random (true) or public (false) address. */
+  bool addr_random;
+  /** Only accept advertisements with manufacturer specific data from this manufacturer or RIOTEE_BLE_MNF_ANY. */
+  uint16_t manufacturer_id;
+} riotee_ble_scan_cfg_t;
+
+/** Advertisement received while scanning. */
+typedef struct {
+  /** Type of the advertisement. */
+  riotee_adv_pdu_type_t pdu_type;
+  /** Advertising address of the sender. */
+  uint8_t addr[6];
+  /** Whether 'addr' is a random address. */
+  bool addr_random;
+  /** Received signal strength in dBm. */
+  int rssi_dbm;
+  /** Advertising data. */
+  uint8_t data[31];
+  /** Size of 'data' in bytes. */
+  size_t data_len;
+} riotee_ble_scan_result_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -91,6 +176,26 @@ extern "C" {
  */
 riotee_rc_t riotee_ble_adv_cfg(riotee_ble_adv_cfg_t *cfg);
 
+/**
+ * @brief Returns a pointer to the custom data in the packet that is currently not transmitted.
+ *
+ * The driver keeps two packets. While one is transmitted, the application can write the next payload directly into the
+ * other one and publish it with riotee_ble_adv_commit(). The inactive packet holds the data of the packet before the
+ * active one, so always write the complete custom data.
+ *
+ * @return Pointer to 'data_len' bytes of custom data or NULL if a committed packet has not been swapped in, yet, or if
+ *         the inactive packet is still on air.
+ */
+void *riotee_ble_adv_data(void);
+
+/**
+ * @brief Publishes the data written to the inactive packet.
+ *
+ * If an advertisement is in progress, the packets are swapped before the next channel, otherwise immediately. Can be
+ * called from interrupt context.
+ */
+void riotee_ble_adv_commit(void);
+
 /**
  * @brief Advertises the given payload on the selected channel(s)
  *
@@ -102,12 +207,60 @@ riotee_rc_t riotee_ble_adv_cfg(riotee_ble_adv_cfg_t *cfg);
  */
 riotee_rc_t riotee_ble_advertise(riotee_adv_ch_t ch);
 
+/**
+ * @brief Sets up the packets for extended advertising with given name, address and payload size.
+ *
+ * @param cfg Pointer to extended advertising configuration.
+ *
+ * @retval RIOTEE_SUCCESS        Successfully prepared advertisement.
+ * @retval RIOTEE_ERR_OVERFLOW   Name and data do not fit into the auxiliary packet.
+ * @retval RIOTEE_ERR_INVALIDARG Invalid set ID, secondary channel or PHY.
+ */
+riotee_rc_t riotee_ble_adv_ext_cfg(riotee_ble_adv_ext_cfg_t *cfg);
+
+/**
+ * @brief Sends an extended advertisement.
+ *
+ * Sends an ADV_EXT_IND on each of the three primary advertising channels, followed by an AUX_ADV_IND with the payload
+ * on the configured secondary channel. The ADV_EXT_IND packets point to the AUX_ADV_IND, which is transmitted at a
+ * fixed offset scheduled with TIMER1. The offset depends on the air time of the ADV_EXT_IND on the primary PHY.
+ *
+ * @retval RIOTEE_SUCCESS       Advertisement successfully sent.
+ * @retval RIOTEE_ERR_RESET     Reset occured while sending advertisement.
+ * @retval RIOTEE_ERR_TEARDOWN  Teardown occured while sending advertisement.
+ */
+riotee_rc_t riotee_ble_advertise_ext(void);
+
+/**
+ * @brief Listens for an advertisement.
+ *
+ * Receives on one advertising channel until an ADV_IND, ADV_NONCONN_IND or ADV_SCAN_IND matching the filters arrives or
+ * the window expires. The window is timed by TIMER1 and ends the reception in hardware, so the energy spent is bounded.
+ * Call this function periodically for duty-cycled scanning.
+ *
+ * @param cfg Pointer to scan configuration.
+ * @param res Pointer to where the received advertisement gets stored.
+ *
+ * @retval RIOTEE_SUCCESS          Matching advertisement received.
+ * @retval RIOTEE_ERR_INVALIDARG   Invalid channel.
+ * @retval RIOTEE_ERR_BLE_TIMEOUT  No matching advertisement received within the window.
+ * @retval RIOTEE_ERR_RESET        Reset occured while scanning.
+ * @retval RIOTEE_ERR_TEARDOWN     Teardown occured while scanning.
+ */
+riotee_rc_t riotee_ble_scan(riotee_ble_scan_cfg_t *cfg, riotee_ble_scan_result_t *res);
+
 /**
  * @brief Initializes BLE driver.
  *
  */
 void riotee_ble_init(void);
 
+/** BLE-specific return codes. */
+enum {
+  /** No matching advertisement received while scanning. */
+  RIOTEE_ERR_BLE_TIMEOUT = -(RIOTEE_RC_BLE_BASE + 1),
+};
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+/**
+ * @defgroup delta Time-series compression
+ * @{
+ *
+ * Streaming encoder that packs slowly changing sensor readings into a compact packet payload.
+ *
+ * Samples are grouped into frames with one value per channel. The first frame of a packet is stored as is, all further
+ * frames as the difference to the previous value of the same channel. Differences are mapped to unsigned integers with
+ * zig-zag encoding and written either as variable-length integers or bit-packed in blocks of
+ * RIOTEE_DELTA_BLOCK_SIZE values that share the bit width of their largest member.
+ *
+ * Packet format (all multi-byte fields little-endian):
+ *  - 1 Byte: mode in bits 4..7, number of channels in bits 0..3
+ *  - 2 Byte: number of frames
+ *  - Zig-zag varint of the first value of each channel
+ *  - Zig-zag deltas of all further frames, channels interleaved. In bit-packing mode, each block of up to
+ *    RIOTEE_DELTA_BLOCK_SIZE deltas starts with one Byte holding the bit width w, followed by the deltas packed LSB-first
+ *    into ceil(n * w / 8) Bytes.
+ *
+ * The encoder state does not contain any pointers. Keep it in a static or global variable and it becomes part of the
+ * checkpoint of the user task, such that a partially filled packet survives power failures.
+ */
+#ifndef __RIOTEE_DELTA_H_
+#define __RIOTEE_DELTA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "riotee.h"
+#include "riotee_stella.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of channels per encoder. */
+#define RIOTEE_DELTA_MAX_CHANNELS 4
+/** Number of deltas sharing one bit width in bit-packing mode. */
+#define RIOTEE_DELTA_BLOCK_SIZE 8
+/** Maximum size of an encoded packet. */
+#define RIOTEE_DELTA_MAX_SIZE RIOTEE_STELLA_MAX_DATA
+/** Size of the packet header. */
+#define RIOTEE_DELTA_HEADER_SIZE 3
+
+typedef enum {
+  /** Deltas are stored as zig-zag varints. Best for irregular signals with occasional large jumps. */
+  RIOTEE_DELTA_MODE_VARINT = 0,
+  /** Deltas are bit-packed in blocks. Best for smooth signals where most deltas need only a few bits. */
+  RIOTEE_DELTA_MODE_BITPACK = 1,
+} riotee_delta_mode_t;
+
+typedef struct {
+  /** Last value of each channel. */
+  int32_t last[RIOTEE_DELTA_MAX_CHANNELS];
+  /** Zig-zag encoded deltas of the current block in bit-packing mode. */
+  uint32_t block[RIOTEE_DELTA_BLOCK_SIZE];
+  /** Number of deltas in the current block. */
+  uint8_t n_block;
+  /** Number of channels. */
+  uint8_t n_channels;
+  /** Encoding mode. */
+  uint8_t mode;
+  /** Number of frames in the current packet. */
+  uint16_t n_frames;
+  /** Number of bytes written to buf, excluding the current block. */
+  uint16_t len;
+  /** Maximum size of the encoded packet. */
+  uint16_t capacity;
+  /** Encoded packet. */
+  uint8_t buf[RIOTEE_DELTA_MAX_SIZE];
+} riotee_delta_enc_t;
+
+/**
+ * @brief Initializes an encoder.
+ *
+ * @param enc Pointer to encoder.
+ * @param n_channels Number of values per frame. Between 1 and RIOTEE_DELTA_MAX_CHANNELS.
+ * @param mode Encoding of deltas.
+ * @param capacity Maximum size of the encoded packet, e.g. RIOTEE_STELLA_MAX_DATA or RIOTEE_STELLA_MAX_DATA_ENC.
+ *
+ * @retval RIOTEE_SUCCESS        Encoder initialized.
+ * @retval RIOTEE_ERR_INVALIDARG Number of channels or capacity out of range.
+ */
+riotee_rc_t riotee_delta_init(riotee_delta_enc_t *enc, unsigned int n_channels, riotee_delta_mode_t mode,
+                              size_t capacity);
+
+/**
+ * @brief Discards all frames and starts a new packet.
+ *
+ * @param enc Pointer to encoder.
+ */
+void riotee_delta_reset(riotee_delta_enc_t *enc);
+
+/**
+ * @brief Appends a frame to the current packet.
+ *
+ * The encoder is left unchanged if the frame does not fit. Send or reset the packet and push the frame again.
+ *
+ * @param enc Pointer to encoder.
+ * @param values One value per channel.
+ *
+ * @retval RIOTEE_SUCCESS      Frame appended.
+ * @retval RIOTEE_ERR_OVERFLOW Packet is full.
+ */
+riotee_rc_t riotee_delta_push(riotee_delta_enc_t *enc, const int32_t *values);
+
+/**
+ * @brief Completes the current packet.
+ *
+ * Writes the header and any pending block to the buffer. Frames can still be appended afterwards.
+ *
+ * @param enc Pointer to encoder.
+ * @return size_t Size of the encoded packet in enc->buf. 0 if the packet is empty.
+ */
+size_t riotee_delta_finish(riotee_delta_enc_t *enc);
+
+/**
+ * @brief Sends the current packet with riotee_stella_send() and starts a new packet on success.
+ *
+ * On failure, the frames are kept and can be sent again later.
+ *
+ * @param enc Pointer to encoder.
+ *
+ * @retval RIOTEE_SUCCESS      Packet sent and acknowledged or packet empty.
+ * @retval Other               See riotee_stella_send().
+ */
+riotee_rc_t riotee_delta_stella_send(riotee_delta_enc_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** @} __RIOTEE_DELTA_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @defgroup duty Energy-neutral duty cycling
+ * @{
+ *
+ * Adapts the period of a periodic task such that its average consumption matches the harvested power.
+ *
+ * Call riotee_duty_wait() instead of a fixed sleep at the end of every iteration. The controller measures the energy
+ * consumed by each iteration and the energy gained while sleeping and sets the period to the time the harvester needs
+ * to replace the consumed energy. A state-of-charge term corrects the period such that the stored energy settles
+ * around a target level. The state of charge is the energy above the 'low' threshold relative to the energy between
+ * the 'low' and the 'high' threshold, see @ref energy.
+ *
+ * Keep the controller in a static or global variable such that it is part of the checkpoint of the user task.
+ */
+#ifndef __RIOTEE_DUTY_H_
+#define __RIOTEE_DUTY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "riotee.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  /** Shortest period in milliseconds. */
+  uint32_t min_period_ms;
+  /** Longest period in milliseconds. */
+  uint32_t max_period_ms;
+  /** Targeted state of charge between 0.0 and 1.0. */
+  float target_soc;
+} riotee_duty_cfg_t;
+
+typedef struct {
+  /** Configuration. */
+  riotee_duty_cfg_t cfg;
+  /** Current period in milliseconds. */
+  uint32_t period_ms;
+  /** Smoothed net power gained while sleeping in watts. */
+  float p_in;
+  /** Available energy when the previous wait returned in joules. */
+  float e_wake;
+  /** Whether p_in holds a measurement. */
+  bool has_p_in;
+  /** Whether e_wake is valid. */
+  bool has_wake;
+} riotee_duty_t;
+
+/**
+ * @brief Initializes a controller.
+ *
+ * The period starts at the maximum.
+ *
+ * @param duty Pointer to controller.
+ * @param cfg Configuration.
+ *
+ * @retval RIOTEE_SUCCESS        Controller initialized.
+ * @retval RIOTEE_ERR_INVALIDARG Periods or target state of charge out of range.
+ */
+riotee_rc_t riotee_duty_init(riotee_duty_t *duty, const riotee_duty_cfg_t *cfg);
+
+/**
+ * @brief Adapts the period and sleeps for it.
+ *
+ * The ADC must be initialized with riotee_adc_init(). The measurements use the capacitance and thresholds of the
+ * energy gauge.
+ *
+ * @param duty Pointer to controller.
+ *
+ * @retval RIOTEE_SUCCESS      Slept for the current period.
+ * @retval RIOTEE_ERR_RESET    Reset occured while sleeping.
+ */
+riotee_rc_t riotee_duty_wait(riotee_duty_t *duty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** @} __RIOTEE_DUTY_H_ */
@@ -0,0 +1,161 @@
+/**
+ * @defgroup energy Energy gauge
+ * @{
+ *
+ * Estimates the energy stored in the capacitor that can be used before the runtime suspends the user task.
+ *
+ * The usable energy is the energy between the measured capacitor voltage and the 'low' threshold, i.e.
+ * E = 0.5 * C * (Vcap^2 - Vlow^2). The capacitance defaults to the on-board capacitance of the Riotee module and must
+ * be updated when additional capacitors are attached. The 'low' threshold is taken from riotee_thresholds_low_get().
+ *
+ * riotee_energy_characterize() measures the actual capacitance and the idle current of the device and stores them in
+ * non-volatile memory. riotee_energy_init() loads the stored results after a reset.
+ *
+ * Every time the runtime suspends the user task at the 'low' threshold and the capacitor recharges to the 'high'
+ * threshold, the recharge time yields an estimate of the harvested power. riotee_energy_harvest_power() returns the
+ * smoothed estimate.
+ *
+ * The ADC must be initialized with riotee_adc_init() before using these functions.
+ */
+#ifndef __RIOTEE_ENERGY_H_
+#define __RIOTEE_ENERGY_H_
+
+#include <stdbool.h>
+
+#include "riotee.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default capacitance in farads. The Riotee module has 66uF on-board. */
+#ifndef RIOTEE_ENERGY_CAPACITANCE
+#define RIOTEE_ENERGY_CAPACITANCE 66e-6f
+#endif
+
+/**
+ * Power in watts drawn from the capacitor while the CPU is busy. Used as known load during characterization. The
+ * default is the active CPU current of 4.7mA on the 2V supply at 90% regulator efficiency. The characterization only
+ * samples the ADC every 250us during the load phase, which adds around 1% to the load.
+ */
+#ifndef RIOTEE_ENERGY_LOAD_POWER
+#define RIOTEE_ENERGY_LOAD_POWER 10.4e-3f
+#endif
+
+/** Maximum duration of the characterization in milliseconds. Increase for large capacitors. */
+#ifndef RIOTEE_ENERGY_CHAR_MAX_MS
+#define RIOTEE_ENERGY_CHAR_MAX_MS 2000
+#endif
+
+/** Weight of older recharge cycles in the harvest power estimate. Each new cycle contributes 1/N. */
+#ifndef RIOTEE_ENERGY_HARVEST_SMOOTHING
+#define RIOTEE_ENERGY_HARVEST_SMOOTHING 4
+#endif
+
+/** Results of the characterization. */
+typedef struct {
+  /** Capacitance in farads. */
+  float capacitance;
+  /** Net current in amperes drawn from the capacitor while the device sleeps. Negative while harvesting. */
+  float i_idle;
+} riotee_energy_char_t;
+
+/**
+ * @brief Loads the results of a previous characterization from non-volatile memory.
+ *
+ * Call this once after reset, e.g. in lateinit. If there are no stored results, the defaults remain in place.
+ *
+ * @retval RIOTEE_SUCCESS      Stored results applied.
+ * @retval RIOTEE_ERR_GENERIC  No stored results or reading the non-volatile memory failed.
+ */
+riotee_rc_t riotee_energy_init(void);
+
+/**
+ * @brief Measures capacitance and idle current and stores them in non-volatile memory.
+ *
+ * Waits until the capacitor is charged and measures the slope of the capacitor voltage, first while sleeping, then
+ * while the CPU is busy. The busy CPU draws a known additional power of RIOTEE_ENERGY_LOAD_POWER. Assuming the
+ * harvested power is constant during the measurement, the difference between the two slopes yields the capacitance.
+ * The idle slope then yields the net current while sleeping, which is the leakage plus the quiescent current of the
+ * device if no energy is harvested. For best results, run the characterization with a weak or disconnected harvester.
+ *
+ * The measurement takes up to RIOTEE_ENERGY_CHAR_MAX_MS milliseconds. The load phase ends early after a drop of 100mV
+ * or before the capacitor voltage gets close to the 'low' threshold.
+ *
+ * @param res Pointer where the results get stored or NULL.
+ *
+ * @retval RIOTEE_SUCCESS      Characterization completed, results applied and stored.
+ * @retval RIOTEE_ERR_RESET    Reset occured during the measurement.
+ * @retval RIOTEE_ERR_TEARDOWN The user task was suspended due to low capacitor voltage during the measurement.
+ * @retval RIOTEE_ERR_GENERIC  Implausible measurement, e.g. due to changing harvesting conditions, or storing failed.
+ */
+riotee_rc_t riotee_energy_characterize(riotee_energy_char_t *res);
+
+/**
+ * @brief Returns the net current drawn from the capacitor while sleeping.
+ *
+ * @return float Current in amperes as measured by riotee_energy_characterize(). 0 if not characterized.
+ */
+float riotee_energy_idle_current_get(void);
+
+/**
+ * @brief Returns the estimated harvest power.
+ *
+ * The estimate is updated whenever the capacitor recharges from the 'low' to the 'high' threshold without a reset in
+ * between. It is the energy stored between the two thresholds divided by the recharge time, exponentially smoothed over
+ * recharge cycles. If the idle current is known from riotee_energy_characterize(), it is added to the estimate. The
+ * estimate is part of the checkpoint and does not change while the harvester keeps the capacitor above the 'low'
+ * threshold.
+ *
+ * @param dst Pointer where the power in watts gets stored.
+ *
+ * @retval RIOTEE_SUCCESS      Estimate stored in dst.
+ * @retval RIOTEE_ERR_GENERIC  No recharge cycle observed yet.
+ */
+riotee_rc_t riotee_energy_harvest_power(float *dst);
+
+/**
+ * @brief Sets the total capacitance on the capacitor rail.
+ *
+ * @param farads Capacitance in farads.
+ */
+void riotee_energy_capacitance_set(float farads);
+
+/**
+ * @brief Returns the capacitance used for the energy estimate.
+ *
+ * @return float Capacitance in farads.
+ */
+float riotee_energy_capacitance_get(void);
+
+/**
+ * @brief Measures the capacitor voltage with a single ADC sample.
+ *
+ * @return float Capacitor voltage in volts.
+ */
+float riotee_energy_vcap(void);
+
+/**
+ * @brief Returns the energy that can be drawn from the capacitor before reaching the 'low' threshold.
+ *
+ * @return float Energy in joules. 0 if the capacitor voltage is at or below the 'low' threshold.
+ */
+float riotee_energy_available(void);
+
+/**
+ * @brief Checks whether an operation can complete with the energy stored in the capacitor.
+ *
+ * Use this before starting an operation that is wasted if interrupted, e.g. a radio transfer. Harvested energy is not
+ * taken into account, so the result is conservative.
+ *
+ * @param cost Energy required by the operation in joules.
+ * @return true The operation can complete before the 'low' threshold is reached.
+ * @return false Not enough energy. Sleep and check again.
+ */
+bool riotee_energy_can_afford(float cost);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** @} __RIOTEE_ENERGY_H_ */
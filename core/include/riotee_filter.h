@@ -0,0 +1,105 @@
+/**
+ * @defgroup filter Send-on-delta filter
+ * @{
+ *
+ * Decides whether a new sensor reading carries enough information to be worth sending.
+ *
+ * A filter has up to RIOTEE_FILTER_MAX_CHANNELS channels with individual configuration. riotee_filter_update() takes
+ * the latest reading of each channel and returns a mask of the channels that should be reported. After the readings
+ * were sent successfully, riotee_filter_commit() marks them as reported. Failed transmissions are thus retried on the
+ * next update.
+ *
+ * Keep the filter in a static or global variable such that it is part of the checkpoint of the user task.
+ */
+#ifndef __RIOTEE_FILTER_H_
+#define __RIOTEE_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "riotee.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of channels per filter. */
+#define RIOTEE_FILTER_MAX_CHANNELS 4
+
+/** Mask selecting all channels. */
+#define RIOTEE_FILTER_ALL 0xFFFFFFFF
+
+/** Configuration of one channel. Set a field to 0 to disable the corresponding trigger. */
+typedef struct {
+  /** Report if the reading differs from the last reported value by more than this. */
+  float abs_delta;
+  /** Report if the reading differs from the last reported value by more than this fraction of the reported value. */
+  float rel_delta;
+  /** Report if the reading changes faster than this many units per second since the previous reading. */
+  float max_rate;
+  /** Report at least every max_silence_ms milliseconds, even if the reading did not change. */
+  uint32_t max_silence_ms;
+} riotee_filter_cfg_t;
+
+typedef struct {
+  /** Configuration of each channel. */
+  riotee_filter_cfg_t cfg[RIOTEE_FILTER_MAX_CHANNELS];
+  /** Last reported value of each channel. */
+  float reported[RIOTEE_FILTER_MAX_CHANNELS];
+  /** Previous reading of each channel. */
+  float last[RIOTEE_FILTER_MAX_CHANNELS];
+  /** Time since the last report of each channel in milliseconds. */
+  uint32_t silence_ms[RIOTEE_FILTER_MAX_CHANNELS];
+  /** Timestamp of the previous reading in ticks of the 32kHz clock. */
+  uint64_t t_last;
+  /** Number of resets at the previous reading. */
+  unsigned int n_reset;
+  /** Number of channels. */
+  uint8_t n_channels;
+  /** Mask of channels that have been reported at least once. */
+  uint8_t valid;
+  /** Whether last and t_last hold a previous reading. */
+  bool has_last;
+} riotee_filter_t;
+
+/**
+ * @brief Initializes a filter.
+ *
+ * @param filter Pointer to filter.
+ * @param cfg Array with one configuration per channel.
+ * @param n_channels Number of channels. Between 1 and RIOTEE_FILTER_MAX_CHANNELS.
+ *
+ * @retval RIOTEE_SUCCESS        Filter initialized.
+ * @retval RIOTEE_ERR_INVALIDARG Number of channels out of range.
+ */
+riotee_rc_t riotee_filter_init(riotee_filter_t *filter, const riotee_filter_cfg_t *cfg, unsigned int n_channels);
+
+/**
+ * @brief Feeds the latest readings into the filter.
+ *
+ * The first reading of a channel is always reported. Afterwards, a channel is reported if any of its enabled triggers
+ * fires. Time is taken from the clock behind riotee_timing_now() without consuming its reset indication. As the clock
+ * restarts after a power failure, the time across a reset is unknown: max_silence_ms counts as expired for the first
+ * reading after a reset and the rate of change is not evaluated for it.
+ *
+ * @param filter Pointer to filter.
+ * @param values One reading per channel.
+ * @return uint32_t Mask with bit i set if channel i should be reported.
+ */
+uint32_t riotee_filter_update(riotee_filter_t *filter, const float *values);
+
+/**
+ * @brief Marks the latest readings of the selected channels as reported.
+ *
+ * Call this after the readings were sent successfully. Pass RIOTEE_FILTER_ALL if all channels were sent.
+ *
+ * @param filter Pointer to filter.
+ * @param mask Mask of reported channels.
+ */
+void riotee_filter_commit(riotee_filter_t *filter, uint32_t mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** @} __RIOTEE_FILTER_H_ */
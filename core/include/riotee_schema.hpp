@@ -0,0 +1,236 @@
+/**
+ * @defgroup schema Payload schemas
+ * @{
+ *
+ * Compile-time description of compact, bit-packed packet payloads.
+ *
+ * A schema is a list of fields with a bit width and, optionally, a fixed-point scaling. Sizes and bit offsets are
+ * computed at compile time and the pack/unpack code consists only of shifts and masks. As the header has no
+ * dependencies on the SDK, the same schema definition can be compiled into a host decoder.
+ *
+ * @code
+ * struct Temperature : riotee::schema::Fixed<10, std::ratio<1, 10>, std::ratio<-40>> {
+ *   static constexpr char name[] = "temperature";
+ * };
+ * struct Count : riotee::schema::UInt<6> {
+ *   static constexpr char name[] = "count";
+ * };
+ * using Payload = riotee::schema::Schema<Temperature, Count>;
+ *
+ * auto buf = Payload::pack(21.5f, 3);
+ * riotee_stella_send(buf.data(), buf.size());
+ * @endcode
+ */
+#ifndef __RIOTEE_SCHEMA_HPP_
+#define __RIOTEE_SCHEMA_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <ratio>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace riotee {
+namespace schema {
+
+/** Unsigned integer field with Bits bits. Values above the maximum saturate. */
+template <unsigned Bits>
+struct UInt {
+  static_assert((Bits > 0) && (Bits <= 32), "Fields must have between 1 and 32 bits");
+  using value_type = uint32_t;
+  static constexpr unsigned bits = Bits;
+  static constexpr uint32_t max_raw = (Bits == 32) ? 0xFFFFFFFFUL : ((1UL << Bits) - 1);
+
+  static constexpr uint32_t encode(value_type value) { return (value < max_raw) ? value : max_raw; }
+  static constexpr value_type decode(uint32_t raw) { return raw; }
+};
+
+/** Two's complement signed integer field with Bits bits. Values outside the range saturate. */
+template <unsigned Bits>
+struct Int {
+  static_assert((Bits > 1) && (Bits <= 32), "Signed fields must have between 2 and 32 bits");
+  using value_type = int32_t;
+  static constexpr unsigned bits = Bits;
+  static constexpr uint32_t max_raw = (Bits == 32) ? 0xFFFFFFFFUL : ((1UL << Bits) - 1);
+  static constexpr int32_t min_value = -(int32_t)(max_raw >> 1) - 1;
+  static constexpr int32_t max_value = (int32_t)(max_raw >> 1);
+
+  static constexpr uint32_t encode(value_type value) {
+    value = (value < min_value) ? min_value : value;
+    value = (value > max_value) ? max_value : value;
+    return (uint32_t)value & max_raw;
+  }
+  /* Sign extension by shifting the field to the top of the word and back */
+  static constexpr value_type decode(uint32_t raw) { return (int32_t)(raw << (32 - Bits)) >> (32 - Bits); }
+};
+
+/**
+ * Fixed-point field with Bits bits representing Scale * raw + Offset.
+ *
+ * E.g. Fixed<10, std::ratio<1, 10>, std::ratio<-40>> covers -40.0 to 62.3 in steps of 0.1. Values are rounded to the
+ * nearest step and saturate at the ends of the range.
+ */
+template <unsigned Bits, typename Scale = std::ratio<1>, typename Offset = std::ratio<0>>
+struct Fixed {
+  static_assert((Bits > 0) && (Bits <= 24), "Fixed-point fields must have between 1 and 24 bits");
+  static_assert(Scale::num > 0, "Scale must be positive");
+  using value_type = float;
+  static constexpr unsigned bits = Bits;
+  static constexpr uint32_t max_raw = (1UL << Bits) - 1;
+  static constexpr float scale = (float)Scale::num / (float)Scale::den;
+  static constexpr float offset = (float)Offset::num / (float)Offset::den;
+  /** Smallest and largest value that can be represented. */
+  static constexpr float min_value = offset;
+  static constexpr float max_value = offset + scale * max_raw;
+
+  static constexpr uint32_t encode(value_type value) {
+    float raw = (value - offset) * (1.0f / scale) + 0.5f;
+    /* Written such that NaN ends up as 0 */
+    raw = (raw > 0.0f) ? raw : 0.0f;
+    raw = (raw < (float)max_raw) ? raw : (float)max_raw;
+    return (uint32_t)raw;
+  }
+  static constexpr value_type decode(uint32_t raw) { return (float)raw * scale + offset; }
+};
+
+/**
+ * Payload consisting of the given fields in order, packed LSB-first into consecutive bits.
+ *
+ * Each field type must provide a static 'name' for the host decoder.
+ */
+template <typename... Fields>
+class Schema {
+  static constexpr size_t n_fields = sizeof...(Fields);
+  static constexpr std::array<unsigned, n_fields> widths = {Fields::bits...};
+
+  static constexpr std::array<unsigned, n_fields> compute_offsets() {
+    std::array<unsigned, n_fields> offsets{};
+    unsigned offset = 0;
+    for (size_t i = 0; i < n_fields; i++) {
+      offsets[i] = offset;
+      offset += widths[i];
+    }
+    return offsets;
+  }
+  static constexpr std::array<unsigned, n_fields> offsets = compute_offsets();
+
+  template <typename F, size_t I = 0>
+  static constexpr size_t find() {
+    static_assert(I < n_fields, "Field is not part of the schema");
+    if constexpr (std::is_same<F, std::tuple_element_t<I, std::tuple<Fields...>>>::value)
+      return I;
+    else
+      return find<F, I + 1>();
+  }
+
+  /* Number of bytes touched by a field */
+  static constexpr unsigned span(unsigned offset, unsigned bits) { return (offset % 8 + bits + 7) / 8; }
+
+  template <unsigned Offset, unsigned Bits>
+  static inline void put(uint8_t *dst, uint32_t raw) {
+    uint64_t v = (uint64_t)raw << (Offset % 8);
+    for (unsigned i = 0; i < span(Offset, Bits); i++)
+      dst[Offset / 8 + i] |= (uint8_t)(v >> (8 * i));
+  }
+
+  template <unsigned Offset, unsigned Bits>
+  static inline uint32_t get(const uint8_t *src) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < span(Offset, Bits); i++)
+      v |= (uint64_t)src[Offset / 8 + i] << (8 * i);
+    return (uint32_t)((v >> (Offset % 8)) & ((1ULL << Bits) - 1));
+  }
+
+  template <size_t... I>
+  static inline void pack_impl(uint8_t *dst, const std::tuple<typename Fields::value_type...> &values,
+                               std::index_sequence<I...>) {
+    (put<offsets[I], widths[I]>(dst, Fields::encode(std::get<I>(values))), ...);
+  }
+
+  template <size_t... I>
+  static inline std::tuple<typename Fields::value_type...> unpack_impl(const uint8_t *src, std::index_sequence<I...>) {
+    return std::tuple<typename Fields::value_type...>(Fields::decode(get<offsets[I], widths[I]>(src))...);
+  }
+
+  template <typename Visitor, size_t... I>
+  static inline void visit_impl(const uint8_t *src, Visitor &&visitor, std::index_sequence<I...>) {
+    (visitor(Fields::name, (double)Fields::decode(get<offsets[I], widths[I]>(src))), ...);
+  }
+
+ public:
+  /** Total number of bits of all fields. */
+  static constexpr size_t n_bits = (Fields::bits + ... + 0);
+  /** Size of the packed payload in bytes. */
+  static constexpr size_t size = (n_bits + 7) / 8;
+
+  /** Unpacked values of all fields in order. */
+  using Record = std::tuple<typename Fields::value_type...>;
+  /** Buffer holding a packed payload. */
+  using Buffer = std::array<uint8_t, size>;
+
+  /** Index of field F in the schema. */
+  template <typename F>
+  static constexpr size_t index = find<F>();
+
+  /** Bit offset of field F in the packed payload. */
+  template <typename F>
+  static constexpr unsigned offset_of = offsets[find<F>()];
+
+  /**
+   * @brief Packs a record into a buffer of at least 'size' bytes.
+   *
+   * @param dst Pointer to destination buffer.
+   * @param values Values of all fields.
+   */
+  static inline void pack(uint8_t *dst, const Record &values) {
+    for (size_t i = 0; i < size; i++)
+      dst[i] = 0;
+    pack_impl(dst, values, std::index_sequence_for<Fields...>{});
+  }
+
+  /** Packs the values of all fields in order. */
+  static inline Buffer pack(typename Fields::value_type... values) {
+    Buffer buf;
+    pack(buf.data(), Record(values...));
+    return buf;
+  }
+
+  /**
+   * @brief Unpacks a payload of at least 'size' bytes.
+   *
+   * @param src Pointer to packed payload.
+   * @return Values of all fields.
+   */
+  static inline Record unpack(const uint8_t *src) { return unpack_impl(src, std::index_sequence_for<Fields...>{}); }
+
+  /** Reads a single field from a packed payload. */
+  template <typename F>
+  static inline typename F::value_type read(const uint8_t *src) {
+    return F::decode(get<offsets[find<F>()], F::bits>(src));
+  }
+
+  /**
+   * @brief Calls visitor(name, value) for every field of a packed payload, e.g. to print it on a host.
+   *
+   * @param src Pointer to packed payload.
+   * @param visitor Callable taking a const char * and a double.
+   */
+  template <typename Visitor>
+  static inline void visit(const uint8_t *src, Visitor &&visitor) {
+    visit_impl(src, std::forward<Visitor>(visitor), std::index_sequence_for<Fields...>{});
+  }
+};
+
+/** Reads field F from an unpacked record of schema S. */
+template <typename S, typename F>
+constexpr typename F::value_type &get(typename S::Record &record) {
+  return std::get<S::template index<F>>(record);
+}
+
+}  // namespace schema
+}  // namespace riotee
+
+#endif /** @} __RIOTEE_SCHEMA_HPP_ */
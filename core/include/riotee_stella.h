@@ -5,6 +5,7 @@
 #ifndef __RIOTEE_STELLA_H_
 #define __RIOTEE_STELLA_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -17,6 +18,15 @@ extern "C" {
 /** Maximum size of payload in stella packet. */
 #define RIOTEE_STELLA_MAX_DATA (255 - sizeof(riotee_stella_pkt_header_t))
 
+/** Size of the key used for encrypting packets. */
+#define RIOTEE_STELLA_KEY_SIZE 16
+
+/**
+ * Maximum size of payload in encrypted stella packet. Encryption adds three bytes of CCM header and a four byte message
+ * integrity check.
+ */
+#define RIOTEE_STELLA_MAX_DATA_ENC (RIOTEE_STELLA_MAX_DATA - 3 - 4)
+
 typedef struct __attribute__((packed)) {
   /** ID of the device sending/receiving this packet. */
   uint32_t dev_id;
@@ -35,6 +45,42 @@ typedef struct __attribute__((packed)) {
   uint8_t data[RIOTEE_STELLA_MAX_DATA];
 } riotee_stella_pkt_t;
 
+/** Slot index indicating that the basestation has not assigned a slot to the device. */
+#define RIOTEE_STELLA_SLOT_NONE 0xFFFF
+
+/**
+ * @brief Time synchronisation and slot assignment sent by the basestation.
+ *
+ * The basestation may send an acknowledgment on a dedicated logical address with this structure in front of the
+ * payload. The driver uses it to synchronize to the basestation clock and strips it before returning the payload.
+ */
+typedef struct __attribute__((packed)) {
+  /** Basestation time at the start of the acknowledgment in ticks of a 32kHz clock. */
+  uint32_t time;
+  /** Ticks elapsed since the start of the current slot frame at 'time'. */
+  uint32_t frame_phase;
+  /** Slot assigned to the device or RIOTEE_STELLA_SLOT_NONE. */
+  uint16_t slot;
+  /** Number of slots per frame. */
+  uint16_t n_slots;
+  /** Length of one slot in ticks of a 32kHz clock. */
+  uint16_t slot_ticks;
+} riotee_stella_sync_t;
+
+/** Link quality and TX power state. */
+typedef struct {
+  /** Smoothed RSSI of received acknowledgments in dBm. 0 if no acknowledgment has been received, yet. */
+  int rssi_dbm;
+  /** RSSI of the last received acknowledgment in dBm. */
+  int rssi_last_dbm;
+  /** Current TX power in dBm. */
+  int txpower_dbm;
+  /** Number of consecutive packets that were not acknowledged. */
+  unsigned int n_miss;
+  /** Whether TX power is adapted automatically. */
+  bool txpower_auto;
+} riotee_stella_link_t;
+
 /**
  * @brief Initializes radio and protocol. Must be called once after reset before using the module.
  */
@@ -121,12 +167,89 @@ uint32_t riotee_stella_get_id(void);
  */
 unsigned int riotee_stella_get_packet_counter(void);
 
+/**
+ * @brief Reads the current basestation time.
+ *
+ * Extrapolates the basestation time from the last received sync information using the local RTC, corrected by the
+ * estimated drift between the two clocks.
+ *
+ * @param dst Pointer to destination buffer.
+ *
+ * @retval RIOTEE_SUCCESS             Basestation time successfully read.
+ * @retval RIOTEE_ERR_STELLA_NOSYNC   No sync information received since the last reset.
+ */
+riotee_rc_t riotee_stella_time_now(uint32_t *dst);
+
+/**
+ * @brief Waits in a low power mode until the start of the next slot assigned by the basestation.
+ *
+ * Call this right before riotee_stella_send(), riotee_stella_receive() or riotee_stella_transceive() to transmit in
+ * the assigned slot of the basestation's TDMA frame.
+ *
+ * @retval RIOTEE_SUCCESS             Assigned slot has started.
+ * @retval RIOTEE_ERR_RESET           Reset occured while waiting.
+ * @retval RIOTEE_ERR_STELLA_NOSYNC   No sync information received since the last reset or no slot assigned.
+ */
+riotee_rc_t riotee_stella_wait_slot(void);
+
+/**
+ * @brief Reads the current link quality estimate and TX power.
+ *
+ * The RSSI is sampled on every received acknowledgment.
+ *
+ * @param dst Pointer to destination buffer.
+ */
+void riotee_stella_get_link(riotee_stella_link_t *dst);
+
+/**
+ * @brief Sets a fixed TX power and disables automatic TX power control.
+ *
+ * @param txpower_dbm TX power in dBm. Supported values are -20, -16, -12, -8, -4, 0, 2, 3, 4, 5, 6, 7 and 8.
+ *
+ * @retval RIOTEE_SUCCESS         TX power successfully set.
+ * @retval RIOTEE_ERR_INVALIDARG  TX power not supported.
+ */
+riotee_rc_t riotee_stella_set_txpower(int txpower_dbm);
+
+/**
+ * @brief Enables automatic TX power control.
+ *
+ * The driver estimates the path loss from the smoothed RSSI of acknowledgments and the TX power of the basestation
+ * and predicts the RSSI of its own packets at the basestation. It steps the TX power down while the prediction for
+ * the next lower setting stays well above the target and steps it up when the prediction falls below the target or
+ * after every packet that was not acknowledged.
+ *
+ * @param target_rssi_dbm Minimum RSSI in dBm that should be maintained, e.g. -80. At most 0dBm.
+ * @param bs_txpower_dbm TX power in dBm at which the basestation sends acknowledgments, e.g. 0. Between -40 and 30dBm.
+ *
+ * @retval RIOTEE_SUCCESS         TX power control enabled.
+ * @retval RIOTEE_ERR_INVALIDARG  Target is below the receiver sensitivity or above 0dBm, or basestation TX power out of
+ *                                range.
+ */
+riotee_rc_t riotee_stella_set_txpower_auto(int target_rssi_dbm, int bs_txpower_dbm);
+
+/**
+ * @brief Enables or disables encryption of packets.
+ *
+ * With a key set, the payload of every packet and acknowledgment is encrypted and authenticated with AES-128 in CCM
+ * mode using the CCM peripheral. The packet header stays in the clear so that the basestation can look up the key of
+ * the device. The nonce is derived from the device ID and a packet counter that never repeats, even across resets. The
+ * key is retained across resets.
+ *
+ * @param key Pointer to RIOTEE_STELLA_KEY_SIZE bytes of key or NULL to disable encryption.
+ */
+void riotee_stella_set_key(const uint8_t *key);
+
 /** Stella-specific return codes. */
 enum {
   /** No acknowledgement received. */
   RIOTEE_ERR_STELLA_NOACK = -(RIOTEE_RC_STELLA_BASE + 1),
   /** Invalid acknowledgement received*/
-  RIOTEE_ERR_STELLA_INVALIDACK = -(RIOTEE_RC_STELLA_BASE + 2)
+  RIOTEE_ERR_STELLA_INVALIDACK = -(RIOTEE_RC_STELLA_BASE + 2),
+  /** Not synchronized to the basestation. */
+  RIOTEE_ERR_STELLA_NOSYNC = -(RIOTEE_RC_STELLA_BASE + 3),
+  /** Packet counter used for encryption is exhausted or could not be reserved. */
+  RIOTEE_ERR_STELLA_NONCE = -(RIOTEE_RC_STELLA_BASE + 4)
 };
 
 #ifdef __cplusplus
@@ -41,6 +41,22 @@ void riotee_thresholds_low_set(thr_low_t thr);
  *
  */
 void riotee_thresholds_high_set(thr_high_t thr);
+
+/**
+ * @brief Returns the currently configured 'low' threshold.
+ *
+ * Derived from the state of the threshold control pins.
+ *
+ * @return float Threshold in volts.
+ */
+float riotee_thresholds_low_get(void);
+
+/**
+ * @brief Returns the currently configured 'high' threshold.
+ *
+ * @return float Threshold in volts.
+ */
+float riotee_thresholds_high_get(void);
 #if defined __cplusplus
 }
 #endif
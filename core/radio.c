@@ -1,14 +1,128 @@
 #include <string.h>
 #include "nrf.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include "radio.h"
 
-RADIO_CALLBACK cb_disabled = NULL;
-RADIO_CALLBACK cb_txready = NULL;
-RADIO_CALLBACK cb_rxready = NULL;
-RADIO_CALLBACK cb_crcok = NULL;
-RADIO_CALLBACK cb_crcerr = NULL;
-RADIO_CALLBACK cb_address = NULL;
+/* Used by drivers that do not have their own context */
+static radio_ctx_t default_ctx;
+static radio_ctx_t *active_ctx = &default_ctx;
+
+/* Subscribers called on radio events in addition to the callbacks of the active context */
+static radio_subscriber_t *subscribers;
+/* Union of the event masks of all subscribers */
+static uint32_t sub_mask;
+
+/* Event register and interrupt enable bit of each radio event */
+static const struct {
+  volatile uint32_t *reg;
+  uint32_t inten;
+} events[RADIO_EVT_COUNT] = {
+    [RADIO_EVT_DISABLED] = {&NRF_RADIO->EVENTS_DISABLED, RADIO_INTENSET_DISABLED_Msk},
+    [RADIO_EVT_TXREADY] = {&NRF_RADIO->EVENTS_TXREADY, RADIO_INTENSET_TXREADY_Msk},
+    [RADIO_EVT_RXREADY] = {&NRF_RADIO->EVENTS_RXREADY, RADIO_INTENSET_RXREADY_Msk},
+    [RADIO_EVT_CRCOK] = {&NRF_RADIO->EVENTS_CRCOK, RADIO_INTENSET_CRCOK_Msk},
+    [RADIO_EVT_CRCERR] = {&NRF_RADIO->EVENTS_CRCERROR, RADIO_INTENSET_CRCERROR_Msk},
+    [RADIO_EVT_ADDRESS] = {&NRF_RADIO->EVENTS_ADDRESS, RADIO_INTENSET_ADDRESS_Msk},
+    [RADIO_EVT_READY] = {&NRF_RADIO->EVENTS_READY, RADIO_INTENSET_READY_Msk},
+    [RADIO_EVT_END] = {&NRF_RADIO->EVENTS_END, RADIO_INTENSET_END_Msk},
+};
+
+/* Translates a mask of radio_evt_t into the corresponding INTEN bits */
+static uint32_t inten_bits(uint32_t evt_mask) {
+  uint32_t inten = 0;
+  while (evt_mask) {
+    inten |= events[__builtin_ctz(evt_mask)].inten;
+    evt_mask &= evt_mask - 1;
+  }
+  return inten;
+}
+
+/* Enables exactly the interrupts required by the active context and the subscribers */
+static void inten_update(void) {
+  uint32_t inten = inten_bits(active_ctx->cb_mask | sub_mask);
+  NRF_RADIO->INTENCLR = ~inten;
+  NRF_RADIO->INTENSET = inten;
+}
+
+static void regs_save(radio_regs_t *regs) {
+  regs->mode = NRF_RADIO->MODE;
+  regs->modecnf0 = NRF_RADIO->MODECNF0;
+  regs->pcnf0 = NRF_RADIO->PCNF0;
+  regs->pcnf1 = NRF_RADIO->PCNF1;
+  regs->base0 = NRF_RADIO->BASE0;
+  regs->base1 = NRF_RADIO->BASE1;
+  regs->prefix0 = NRF_RADIO->PREFIX0;
+  regs->prefix1 = NRF_RADIO->PREFIX1;
+  regs->txaddress = NRF_RADIO->TXADDRESS;
+  regs->rxaddresses = NRF_RADIO->RXADDRESSES;
+  regs->crccnf = NRF_RADIO->CRCCNF;
+  regs->crcpoly = NRF_RADIO->CRCPOLY;
+  regs->crcinit = NRF_RADIO->CRCINIT;
+  regs->txpower = NRF_RADIO->TXPOWER;
+  regs->frequency = NRF_RADIO->FREQUENCY;
+  regs->datawhiteiv = NRF_RADIO->DATAWHITEIV;
+  regs->packetptr = NRF_RADIO->PACKETPTR;
+  regs->shorts = NRF_RADIO->SHORTS;
+  regs->tifs = NRF_RADIO->TIFS;
+  regs->dacnf = NRF_RADIO->DACNF;
+}
+
+static void regs_load(const radio_regs_t *regs) {
+  NRF_RADIO->MODE = regs->mode;
+  NRF_RADIO->MODECNF0 = regs->modecnf0;
+  NRF_RADIO->PCNF0 = regs->pcnf0;
+  NRF_RADIO->PCNF1 = regs->pcnf1;
+  NRF_RADIO->BASE0 = regs->base0;
+  NRF_RADIO->BASE1 = regs->base1;
+  NRF_RADIO->PREFIX0 = regs->prefix0;
+  NRF_RADIO->PREFIX1 = regs->prefix1;
+  NRF_RADIO->TXADDRESS = regs->txaddress;
+  NRF_RADIO->RXADDRESSES = regs->rxaddresses;
+  NRF_RADIO->CRCCNF = regs->crccnf;
+  NRF_RADIO->CRCPOLY = regs->crcpoly;
+  NRF_RADIO->CRCINIT = regs->crcinit;
+  NRF_RADIO->TXPOWER = regs->txpower;
+  NRF_RADIO->FREQUENCY = regs->frequency;
+  NRF_RADIO->DATAWHITEIV = regs->datawhiteiv;
+  NRF_RADIO->PACKETPTR = regs->packetptr;
+  NRF_RADIO->SHORTS = regs->shorts;
+  NRF_RADIO->TIFS = regs->tifs;
+  NRF_RADIO->DACNF = regs->dacnf;
+}
+
+void radio_ctx_init(radio_ctx_t *ctx) {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  memset(ctx, 0, sizeof(radio_ctx_t));
+  if (ctx == active_ctx)
+    inten_update();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void radio_ctx_activate(radio_ctx_t *ctx) {
+  UBaseType_t mask;
+
+  if (ctx == active_ctx)
+    return;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  NRF_RADIO->INTENCLR = 0xFFFFFFFF;
+
+  regs_save(&active_ctx->regs);
+  active_ctx->valid = true;
+  if (ctx->valid)
+    regs_load(&ctx->regs);
+
+  /* Events left over by the previous protocol must not reach the callbacks of the new one */
+  for (unsigned int i = 0; i < RADIO_EVT_COUNT; i++)
+    *events[i].reg = 0;
+
+  active_ctx = ctx;
+  NRF_RADIO->INTENSET = inten_bits(ctx->cb_mask | sub_mask);
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
 
 void radio_init() {
   NRF_PPI->CH[18].EEP = (uint32_t)&NRF_CLOCK->EVENTS_HFCLKSTARTED;
@@ -27,104 +141,87 @@ void radio_stop() {
 }
 
 int radio_cb_register(radio_evt_t evt, RADIO_CALLBACK cb) {
-  switch (evt) {
-    case RADIO_EVT_DISABLED:
-      cb_disabled = cb;
-      NRF_RADIO->EVENTS_DISABLED = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
-      break;
-    case RADIO_EVT_RXREADY:
-      cb_rxready = cb;
-      NRF_RADIO->EVENTS_RXREADY = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_RXREADY_Msk;
-      break;
-    case RADIO_EVT_TXREADY:
-      cb_txready = cb;
-      NRF_RADIO->EVENTS_TXREADY = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_TXREADY_Msk;
-      break;
-    case RADIO_EVT_CRCOK:
-      cb_crcok = cb;
-      NRF_RADIO->EVENTS_CRCOK = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_CRCOK_Msk;
-      break;
-    case RADIO_EVT_CRCERR:
-      cb_crcerr = cb;
-      NRF_RADIO->EVENTS_CRCERROR = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_CRCERROR_Msk;
-      break;
-    case RADIO_EVT_ADDRESS:
-      cb_address = cb;
-      NRF_RADIO->EVENTS_ADDRESS = 0;
-      NRF_RADIO->INTENSET = RADIO_INTENSET_ADDRESS_Msk;
-      break;
-    default:
-      return -1;
-  }
+  if (evt >= RADIO_EVT_COUNT)
+    return -1;
+
+  active_ctx->cb[evt] = cb;
+  active_ctx->cb_mask |= (1UL << evt);
+  *events[evt].reg = 0;
+  NRF_RADIO->INTENSET = events[evt].inten;
   return 0;
 }
 
 int radio_cb_unregister(radio_evt_t evt) {
-  switch (evt) {
-    case RADIO_EVT_DISABLED:
-      cb_disabled = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_DISABLED_Msk;
-      break;
-    case RADIO_EVT_RXREADY:
-      cb_rxready = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_RXREADY_Msk;
-      break;
-    case RADIO_EVT_TXREADY:
-      cb_txready = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_TXREADY_Msk;
-      break;
-    case RADIO_EVT_CRCOK:
-      cb_crcok = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_CRCOK_Msk;
-      break;
-    case RADIO_EVT_CRCERR:
-      cb_crcerr = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_CRCERROR_Msk;
-      break;
-    case RADIO_EVT_ADDRESS:
-      cb_address = NULL;
-      NRF_RADIO->INTENCLR = RADIO_INTENCLR_ADDRESS_Msk;
-      break;
-    default:
-      return -1;
+  if (evt >= RADIO_EVT_COUNT)
+    return -1;
+
+  active_ctx->cb[evt] = NULL;
+  active_ctx->cb_mask &= ~(1UL << evt);
+  /* Subscribers may still be interested in the event */
+  if (!(sub_mask & (1UL << evt)))
+    NRF_RADIO->INTENCLR = events[evt].inten;
+  return 0;
+}
+
+void radio_subscribe(radio_subscriber_t *sub) {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  sub->next = subscribers;
+  subscribers = sub;
+  sub_mask |= sub->evt_mask;
+  inten_update();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void radio_unsubscribe(radio_subscriber_t *sub) {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  sub_mask = 0;
+  for (radio_subscriber_t **p = &subscribers; *p != NULL;) {
+    if (*p == sub) {
+      *p = sub->next;
+      continue;
+    }
+    sub_mask |= (*p)->evt_mask;
+    p = &(*p)->next;
   }
+  inten_update();
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+int radio_ppi_bind(radio_evt_t evt, unsigned int ch, volatile uint32_t *task) {
+  if ((evt >= RADIO_EVT_COUNT) || (ch >= sizeof(NRF_PPI->CH) / sizeof(NRF_PPI->CH[0])))
+    return -1;
+
+  NRF_PPI->CH[ch].EEP = (uint32_t)events[evt].reg;
+  NRF_PPI->CH[ch].TEP = (uint32_t)task;
+  NRF_PPI->CHENSET = (1UL << ch);
   return 0;
 }
 
+void radio_ppi_unbind(unsigned int ch) {
+  NRF_PPI->CHENCLR = (1UL << ch);
+}
+
 void RADIO_IRQHandler(void) {
-  if (NRF_RADIO->EVENTS_DISABLED == 1) {
-    NRF_RADIO->EVENTS_DISABLED = 0;
-    if (cb_disabled != NULL)
-      cb_disabled();
-  }
-  if (NRF_RADIO->EVENTS_RXREADY == 1) {
-    NRF_RADIO->EVENTS_RXREADY = 0;
-    if (cb_rxready != NULL)
-      cb_rxready();
-  }
-  if (NRF_RADIO->EVENTS_TXREADY == 1) {
-    NRF_RADIO->EVENTS_TXREADY = 0;
-    if (cb_txready != NULL)
-      cb_txready();
-  }
-  if (NRF_RADIO->EVENTS_CRCOK == 1) {
-    NRF_RADIO->EVENTS_CRCOK = 0;
-    if (cb_crcok != NULL)
-      cb_crcok();
-  }
-  if (NRF_RADIO->EVENTS_CRCERROR == 1) {
-    NRF_RADIO->EVENTS_CRCERROR = 0;
-    if (cb_crcerr != NULL)
-      cb_crcerr();
+  uint32_t enabled = active_ctx->cb_mask | sub_mask;
+  uint32_t pending = 0;
+
+  /* Collect and clear all pending events first, such that the callbacks see a consistent state */
+  for (uint32_t m = enabled; m; m &= m - 1) {
+    unsigned int i = __builtin_ctz(m);
+    if (*events[i].reg) {
+      *events[i].reg = 0;
+      pending |= (1UL << i);
+    }
   }
-  if (NRF_RADIO->EVENTS_ADDRESS == 1) {
-    NRF_RADIO->EVENTS_ADDRESS = 0;
-    if (cb_address != NULL)
-      cb_address();
+
+  for (; pending; pending &= pending - 1) {
+    unsigned int i = __builtin_ctz(pending);
+    /* The protocol comes first as it may have to react within microseconds */
+    if (active_ctx->cb[i] != NULL)
+      active_ctx->cb[i]();
+    for (radio_subscriber_t *sub = subscribers; sub != NULL; sub = sub->next) {
+      if (sub->evt_mask & (1UL << i))
+        sub->hook((radio_evt_t)i);
+    }
   }
 }
@@ -1,6 +1,9 @@
 #ifndef __RADIO_H__
 #define __RADIO_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef void (*RADIO_CALLBACK)(void);
 
 typedef enum {
@@ -15,11 +18,79 @@ typedef enum {
   /* Packet received, but CRC check failed */
   RADIO_EVT_CRCERR,
   /* An address has been decoded */
-  RADIO_EVT_ADDRESS
+  RADIO_EVT_ADDRESS,
+  /* Radio has ramped up */
+  RADIO_EVT_READY,
+  /* Packet sent or received */
+  RADIO_EVT_END,
+  RADIO_EVT_COUNT
 } radio_evt_t;
 
+/* Callback of a subscriber. Receives the event that has occurred. */
+typedef void (*RADIO_HOOK)(radio_evt_t evt);
+
+/* Subscriber to radio events, e.g. for tracing. Owned by the caller and must stay valid while subscribed. */
+typedef struct radio_subscriber {
+  RADIO_HOOK hook;
+  /* Bit i selects event i */
+  uint32_t evt_mask;
+  struct radio_subscriber *next;
+} radio_subscriber_t;
+
+/* Radio registers that make up the configuration of a protocol */
+typedef struct {
+  uint32_t mode;
+  uint32_t modecnf0;
+  uint32_t pcnf0;
+  uint32_t pcnf1;
+  uint32_t base0;
+  uint32_t base1;
+  uint32_t prefix0;
+  uint32_t prefix1;
+  uint32_t txaddress;
+  uint32_t rxaddresses;
+  uint32_t crccnf;
+  uint32_t crcpoly;
+  uint32_t crcinit;
+  uint32_t txpower;
+  uint32_t frequency;
+  uint32_t datawhiteiv;
+  uint32_t packetptr;
+  uint32_t shorts;
+  uint32_t tifs;
+  uint32_t dacnf;
+} radio_regs_t;
+
+/* Radio configuration and callbacks of one protocol */
+typedef struct {
+  radio_regs_t regs;
+  RADIO_CALLBACK cb[RADIO_EVT_COUNT];
+  /* Bit i is set if cb[i] is registered */
+  uint32_t cb_mask;
+  /* regs holds a configuration that can be loaded into the radio */
+  bool valid;
+} radio_ctx_t;
+
+/**
+ * @brief Clears a context. Must be called by the driver owning the context before configuring the radio.
+ *
+ * @param ctx Pointer to context
+ */
+void radio_ctx_init(radio_ctx_t *ctx);
+
 /**
- * @brief Registers a callback in the radio isr.
+ * @brief Makes a context the active one.
+ *
+ * Saves the radio registers into the previously active context, loads the registers of the new context and switches
+ * to its callbacks in one step. Does nothing if the context is already active. A freshly initialized context keeps the
+ * current register values, which the owner then overwrites with its configuration. The radio must be disabled.
+ *
+ * @param ctx Pointer to context
+ */
+void radio_ctx_activate(radio_ctx_t *ctx);
+
+/**
+ * @brief Registers a callback in the radio isr for the active context.
  *
  * @param evt Event for which callback is registered
  * @param cb Pointer to callback function
@@ -28,13 +99,48 @@ typedef enum {
 int radio_cb_register(radio_evt_t evt, RADIO_CALLBACK cb);
 
 /**
- * @brief Unregisters a previously registered callback.
+ * @brief Unregisters a previously registered callback of the active context.
  *
  * @param evt Event for which callback was registered.
  * @return int
  */
 int radio_cb_unregister(radio_evt_t evt);
 
+/**
+ * @brief Adds a subscriber that gets called on the selected events, independent of the active context.
+ *
+ * Subscribers are called after the callback of the active context.
+ *
+ * @param sub Pointer to subscriber with hook and evt_mask set
+ */
+void radio_subscribe(radio_subscriber_t *sub);
+
+/**
+ * @brief Removes a subscriber.
+ *
+ * @param sub Pointer to previously added subscriber
+ */
+void radio_unsubscribe(radio_subscriber_t *sub);
+
+/**
+ * @brief Connects a radio event to a peripheral task through a PPI channel and enables the channel.
+ *
+ * The task gets triggered by hardware without involving the CPU.
+ *
+ * @param evt Radio event
+ * @param ch PPI channel
+ * @param task Address of the task register
+ * @return int
+ */
+int radio_ppi_bind(radio_evt_t evt, unsigned int ch, volatile uint32_t *task);
+
+/**
+ * @brief Disables a PPI channel previously set up with radio_ppi_bind().
+ *
+ * @param ch PPI channel
+ */
+void radio_ppi_unbind(unsigned int ch);
+
 /**
  * @brief Initializes the radio peripheral. Must be called before radio can be used.
  *
@@ -53,4 +159,4 @@ void radio_start();
  */
 void radio_stop();
 
-#endif /* __RADIO_H__ */
\ No newline at end of file
+#endif /* __RADIO_H__ */
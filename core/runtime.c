@@ -162,6 +162,32 @@ static int checkpoint_store() {
   return 0;
 }
 
+/* The system task may access the NVM for a checkpoint at any time. Suspending the scheduler keeps it out while the
+ * user task accesses the metadata region. */
+int runtime_meta_read(uint32_t offset, void *dst, size_t size) {
+  int rc;
+
+  vTaskSuspendAll();
+  if ((rc = nvm_begin_read(NVM_META_START + offset)) == 0) {
+    rc = nvm_read((uint8_t *)dst, size);
+    nvm_end();
+  }
+  xTaskResumeAll();
+  return rc;
+}
+
+int runtime_meta_write(uint32_t offset, void *src, size_t size) {
+  int rc;
+
+  vTaskSuspendAll();
+  if ((rc = nvm_begin_write(NVM_META_START + offset)) == 0) {
+    rc = nvm_write((uint8_t *)src, size);
+    nvm_end();
+  }
+  xTaskResumeAll();
+  return rc;
+}
+
 /* Loads a snapshot from NVM into task stack and static/global variables. */
 static int checkpoint_load() {
   int rc;
@@ -277,6 +303,8 @@ static void teardown(void) {
 static void sys_handle_suspend(void) {
   unsigned long notification_value;
   int rc;
+  /* Time of the 'low' threshold to measure the recharge time */
+  uint64_t t_low = timing_ticks();
 
   /* Switch off power-hungry devices registered in drivers */
   teardown();
@@ -300,6 +328,7 @@ static void sys_handle_suspend(void) {
   if (notification_value == EVT_RUNTIME_PWRGD_H) {
     sys_cancel_timer();
     xTaskNotifyStateClearIndexed(sys_task_handle, 1);
+    energy_recharged(timing_ticks() - t_low);
     return;
   }
 
@@ -318,6 +347,7 @@ static void sys_handle_suspend(void) {
   /* Recharged? */
   if (notification_value == EVT_RUNTIME_PWRGD_H) {
     gpint_unregister(PIN_PWRGD_L);
+    energy_recharged(timing_ticks() - t_low);
     return;
   }
 
@@ -328,6 +358,8 @@ static void sys_handle_suspend(void) {
 
   /* Wait until capacitor is recharged */
   xTaskNotifyWaitIndexed(1, 0xFFFFFFFF, 0xFFFFFFFF, &notification_value, portMAX_DELAY);
+  if (notification_value == EVT_RUNTIME_PWRGD_H)
+    energy_recharged(timing_ticks() - t_low);
 }
 
 /* High priority system task initializes runtime, and handles intermittent execution and checkpointing. */
@@ -36,6 +36,27 @@ extern TaskHandle_t sys_task_handle;
 
 extern runtime_stats_t runtime_stats;
 
+/* Reads the 56-bit RTC0-driven tick counter. Can be called from ISRs and does not consume the reset indication of
+ * riotee_timing_now(). */
+uint64_t timing_ticks(void);
+
+/* Reports the time in ticks that the capacitor took to recharge from the 'low' to the 'high' threshold. Called by the
+ * system task. */
+void energy_recharged(uint64_t ticks);
+
+/* Region at the top of the FRAM where the SDK persists small records independent of checkpoints */
+#define NVM_META_START 0x23F00
+/* Offsets of the records of individual modules in the metadata region */
+#define NVM_META_STELLA 0x00
+#define NVM_META_ENERGY 0x10
+
+/* Marks a valid record in the metadata region */
+#define NVM_META_SIG 0xC0FFEE11
+
+/* Reads/writes a record in the metadata region. Safe to call from the user task. */
+int runtime_meta_read(uint32_t offset, void *dst, size_t size);
+int runtime_meta_write(uint32_t offset, void *src, size_t size);
+
 #define TEARDOWN_FUN(x) void (*x)() __attribute__((section(".teardown")))
 
 #endif /* __RUNTIME_H_ */
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <string.h>
 #include "nrfx.h"
 #include "FreeRTOS.h"
@@ -6,6 +7,7 @@
 #include "riotee_stella.h"
 #include "radio.h"
 #include "runtime.h"
+#include "riotee_timing.h"
 
 static riotee_stella_pkt_t _rx_pkt_buf __attribute__((section(".retained_bss")));
 static riotee_stella_pkt_t _tx_pkt_buf __attribute__((section(".retained_bss")));
@@ -14,6 +16,53 @@ static riotee_stella_pkt_t *rx_buf_ptr __attribute__((section(".retained_bss")))
 /* Counts number of transmitted packets */
 static unsigned int pkt_counter __attribute__((section(".retained_bss")));
 
+/* Time synchronisation state. Local time restarts after a reset, so the state is only valid while n_reset matches. */
+static struct {
+  riotee_stella_sync_t sync;
+  /* Local time at the start of the acknowledgment that carried the sync information */
+  uint64_t t_local;
+  unsigned int n_reset;
+  /* Drift of the local clock relative to the basestation clock in parts per million */
+  int32_t drift_ppm;
+  bool valid;
+} sync_state __attribute__((section(".retained_bss")));
+
+/* Local time, matching logical address and RSSI of the last received packet */
+static uint64_t t_rx;
+static uint32_t rx_match;
+static uint8_t rx_rssi;
+
+/* Supported TX power settings in dBm in ascending order */
+static const int8_t txpower_lut[] = {-20, -16, -12, -8, -4, 0, 2, 3, 4, 5, 6, 7, 8};
+#define TXPOWER_IDX_0DBM 5
+#define N_TXPOWER (sizeof(txpower_lut) / sizeof(txpower_lut[0]))
+
+/* Reception of 1Mbit packets is reliable above this RSSI */
+#define SENSITIVITY_DBM -90
+/* Range of TX power settings of the basestation that are accepted for path loss estimation */
+#define BS_TXPOWER_MIN_DBM -40
+#define BS_TXPOWER_MAX_DBM 30
+/* Margin above target RSSI that must be exceeded before TX power is reduced */
+#define TXPOWER_HYSTERESIS_DB 6
+/* Number of consecutive acknowledgments before TX power is reduced */
+#define TXPOWER_N_STEPDOWN 4
+
+/* Link quality tracking and TX power control */
+static struct {
+  /* Smoothed RSSI of acknowledgments in 1/16 dBm */
+  int32_t rssi_avg_q4;
+  int8_t rssi_last;
+  unsigned int txpower_idx;
+  /* Target RSSI at the basestation and TX power of the basestation if TX power control is enabled */
+  int8_t target_rssi;
+  int8_t bs_txpower;
+  bool txpower_auto;
+  /* Number of consecutive acknowledged and missed packets */
+  unsigned int n_ack;
+  unsigned int n_miss;
+  bool initialized;
+} link __attribute__((section(".retained_bss")));
+
 enum {
   EVT_STELLA_TIMEOUT = EVT_STELLA_BASE + 0,
   EVT_STELLA_RCVD = EVT_STELLA_BASE + 1,
@@ -25,6 +74,8 @@ enum {
   LA_UPLINK_IDX = 1,
   /* Downlink logical address index */
   LA_DOWNLINK_IDX = 2,
+  /* Downlink logical address index for acknowledgments carrying sync information */
+  LA_DOWNLINK_SYNC_IDX = 3,
 };
 
 enum {
@@ -32,16 +83,71 @@ enum {
   LA_UPLINK = 0x5D,
   /* Downlink logical address index */
   LA_DOWNLINK = 0xF7,
+  /* Downlink logical address for acknowledgments carrying sync information */
+  LA_DOWNLINK_SYNC = 0x8C,
 };
 
+/* Minimum number of ticks between computing the next slot and the start of the slot */
+#define SLOT_MIN_LEAD_TICKS 4
+/* riotee_sleep_ticks() programs a 24-bit RTC compare register, longer waits are split into chunks */
+#define SLEEP_MAX_TICKS (1UL << 23)
+
 static uint32_t _dev_id __attribute__((section(".retained_bss")));
 
+/* Layout of the CCM configuration in RAM */
+typedef struct __attribute__((packed)) {
+  uint8_t key[RIOTEE_STELLA_KEY_SIZE];
+  /* 39-bit packet counter */
+  uint64_t counter;
+  /* 1 for uplink, 0 for downlink */
+  uint8_t direction;
+  uint8_t iv[8];
+} ccm_cnf_t;
+
+/* Encryption state. The key is retained, the position of the packet counter must not roll back with a checkpoint. */
+static struct {
+  ccm_cnf_t cnf;
+  bool enabled;
+} crypt __attribute__((section(".retained_bss")));
+
+/* Input/output format of the CCM: Header byte (S0), length, RFU byte and payload */
+typedef struct __attribute__((packed)) {
+  uint8_t s0;
+  uint8_t len;
+  uint8_t rfu;
+  uint8_t data[RIOTEE_STELLA_MAX_DATA_ENC + 4];
+} ccm_pkt_t;
+
+/* Plaintext of the packet that is encrypted or the acknowledgment that is decrypted */
+static ccm_pkt_t ccm_pkt;
+/* CCM needs 16 bytes plus maximum packet size of scratch memory */
+static uint8_t ccm_scratch[16 + sizeof(ccm_pkt.data)];
+
+/* Packet counters are reserved in blocks in NVM so that a counter is never used twice */
+#define NONCE_BLOCK_SIZE 16
+/* The packet ID and the S0 byte transport 24 bits of the counter */
+#define NONCE_MAX (1UL << 24)
+
+/* PPI channel that starts decryption at the end of a received acknowledgment */
+#define CCM_PPI_CH 19
+static uint32_t nonce_next;
+static uint32_t nonce_limit;
+
+/* Fixed upper half of the initialization vector */
+static const uint8_t iv_tag[4] = {'S', 'T', 'L', 'A'};
+
 TEARDOWN_FUN(stella_teardown_ptr);
 
+/* Radio configuration and callbacks of Stella */
+static radio_ctx_t stella_ctx;
+
 /* Valid acknowledgment received */
 static void radio_crc_ok(void) {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+  t_rx = timing_ticks();
+  rx_match = NRF_RADIO->RXMATCH;
+  rx_rssi = NRF_RADIO->RSSISAMPLE;
   radio_stop();
   stella_teardown_ptr = NULL;
   xTaskNotifyIndexedFromISR(usr_task_handle, 1, EVT_STELLA_RCVD, eSetBits, &xHigherPriorityTaskWoken);
@@ -74,6 +180,13 @@ static void radio_txready(void) {
 static void radio_rxready(void) {
   NRF_RADIO->SHORTS &= ~(RADIO_SHORTS_DISABLED_RXEN_Msk);
 
+  if (crypt.enabled) {
+    /* Keystream is ready long before the acknowledgment has been received */
+    NRF_CCM->TASKS_KSGEN = 1;
+    /* Decrypt the acknowledgment as soon as it has been received */
+    radio_ppi_bind(RADIO_EVT_END, CCM_PPI_CH, &NRF_CCM->TASKS_CRYPT);
+  }
+
   /* Notify us when an address is received */
   radio_cb_register(RADIO_EVT_ADDRESS, radio_address);
   /* Set a timeout for reception of an address */
@@ -94,8 +207,15 @@ static int timer_init(void) {
 }
 
 void riotee_stella_init() {
-  /* 0dBm TX power */
-  NRF_RADIO->TXPOWER = (RADIO_TXPOWER_TXPOWER_0dBm << RADIO_TXPOWER_TXPOWER_Pos);
+  radio_ctx_init(&stella_ctx);
+  radio_ctx_activate(&stella_ctx);
+
+  /* 0dBm TX power unless the application has chosen another setting */
+  if (!link.initialized) {
+    link.txpower_idx = TXPOWER_IDX_0DBM;
+    link.initialized = true;
+  }
+  NRF_RADIO->TXPOWER = (uint8_t)txpower_lut[link.txpower_idx];
   /* 2476 MHz frequency */
   NRF_RADIO->FREQUENCY = 76UL;
   /* BLE 1MBit */
@@ -106,10 +226,10 @@ void riotee_stella_init() {
   /* We'll only use base address 1, i.e. logical addresses 1-7 */
   NRF_RADIO->BASE1 = 0xFB235D41;
 
-  NRF_RADIO->PREFIX0 = (LA_DOWNLINK << 16) | (LA_UPLINK << 8);
+  NRF_RADIO->PREFIX0 = (LA_DOWNLINK_SYNC << 24) | (LA_DOWNLINK << 16) | (LA_UPLINK << 8);
 
   /* We want to receive on downlink logical addresses */
-  NRF_RADIO->RXADDRESSES = (1UL << LA_DOWNLINK_IDX);
+  NRF_RADIO->RXADDRESSES = (1UL << LA_DOWNLINK_IDX) | (1UL << LA_DOWNLINK_SYNC_IDX);
 
   /* And send on uplink logical address */
   NRF_RADIO->TXADDRESS = LA_UPLINK_IDX;
@@ -127,8 +247,9 @@ void riotee_stella_init() {
   NRF_RADIO->CRCINIT = 0xABUL;
   NRF_RADIO->CRCPOLY = 0x108UL;
 
-  /* Set default shorts */
-  NRF_RADIO->SHORTS = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk;
+  /* Set default shorts. RSSI is sampled when the address of the acknowledgment is received. */
+  NRF_RADIO->SHORTS = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk | RADIO_SHORTS_ADDRESS_RSSISTART_Msk |
+                      RADIO_SHORTS_DISABLED_RSSISTOP_Msk;
 
   /* Set the default device ID */
   riotee_stella_set_id(NRF_FICR->DEVICEADDR[0]);
@@ -142,6 +263,10 @@ void riotee_stella_init() {
   radio_cb_register(RADIO_EVT_TXREADY, radio_txready);
 
   NRF_PPI->CHENSET = PPI_CHENSET_CH18_Msk;
+
+  NRF_CCM->CNFPTR = (uint32_t)&crypt.cnf;
+  NRF_CCM->SCRATCHPTR = (uint32_t)ccm_scratch;
+  NRF_CCM->MAXPACKETSIZE = sizeof(ccm_pkt.data);
 }
 
 /* Timeout for reception of the acknowledgment */
@@ -161,6 +286,7 @@ void TIMER2_IRQHandler(void) {
 
 static void teardown(void) {
   radio_stop();
+  radio_ppi_unbind(CCM_PPI_CH);
   radio_cb_unregister(RADIO_EVT_ADDRESS);
   NRF_TIMER2->TASKS_STOP = 1;
   xTaskNotifyIndexed(usr_task_handle, 1, EVT_TEARDOWN, eSetBits);
@@ -206,9 +332,57 @@ static inline int wait_for_completion(riotee_stella_pkt_t *rx_pkt, riotee_stella
   return RIOTEE_SUCCESS;
 }
 
+/* Updates link quality estimate and TX power after a transmission */
+static void link_update(riotee_rc_t rc) {
+  int32_t path_loss;
+
+  if (rc == RIOTEE_SUCCESS) {
+    int32_t rssi_q4 = -((int32_t)rx_rssi << 4);
+    link.rssi_last = -rx_rssi;
+    /* First sample initializes the estimate, then exponential smoothing with factor 1/8 */
+    if (link.rssi_avg_q4 == 0)
+      link.rssi_avg_q4 = rssi_q4;
+    else
+      link.rssi_avg_q4 += (rssi_q4 - link.rssi_avg_q4) / 8;
+    link.n_ack++;
+    link.n_miss = 0;
+  } else if (rc == RIOTEE_ERR_STELLA_NOACK) {
+    link.n_ack = 0;
+    link.n_miss++;
+  } else {
+    /* Reset/teardown tell us nothing about the link */
+    return;
+  }
+
+  if (!link.txpower_auto)
+    return;
+
+  /* The acknowledgments are sent with the fixed TX power of the basestation. Their RSSI yields the path loss, which
+   * predicts the RSSI of our packets at the basestation independent of our own TX power. */
+  path_loss = link.bs_txpower - (link.rssi_avg_q4 >> 4);
+
+  if ((link.n_miss > 0) && (link.txpower_idx < N_TXPOWER - 1)) {
+    link.txpower_idx++;
+  } else if (link.rssi_avg_q4 == 0) {
+    /* No acknowledgment yet */
+    return;
+  } else if ((txpower_lut[link.txpower_idx] - path_loss < link.target_rssi) && (link.txpower_idx < N_TXPOWER - 1)) {
+    link.txpower_idx++;
+  } else if ((link.n_ack >= TXPOWER_N_STEPDOWN) && (link.txpower_idx > 0)) {
+    if (txpower_lut[link.txpower_idx - 1] - path_loss >= link.target_rssi + TXPOWER_HYSTERESIS_DB) {
+      link.txpower_idx--;
+      link.n_ack = 0;
+    }
+  }
+}
+
 static inline riotee_rc_t _transceive(riotee_stella_pkt_t *rx_pkt, riotee_stella_pkt_t *tx_pkt) {
   unsigned long notification_value;
 
+  /* Restores the Stella configuration if BLE has used the radio in the meantime */
+  radio_ctx_activate(&stella_ctx);
+  NRF_RADIO->TXPOWER = (uint8_t)txpower_lut[link.txpower_idx];
+
   taskENTER_CRITICAL();
   /* Packet transmission will start automatically when HFXO is running */
   NRF_CLOCK->TASKS_HFCLKSTART = 1;
@@ -229,6 +403,7 @@ static inline riotee_rc_t _transceive(riotee_stella_pkt_t *rx_pkt, riotee_stella
 
   /* Count the packet whether successful or not. */
   pkt_counter++;
+  radio_ppi_unbind(CCM_PPI_CH);
 
   /* Make sure HFXO has stopped so the next packet can be sent right after returning. */
   while ((NRF_CLOCK->HFCLKSTAT & CLOCK_HFCLKSTAT_SRC_Msk) == CLOCK_HFCLKSTAT_SRC_Xtal) {
@@ -260,30 +435,240 @@ static inline riotee_rc_t _transceive(riotee_stella_pkt_t *rx_pkt, riotee_stella
   return RIOTEE_SUCCESS;
 }
 
+/* Takes the next packet counter, reserving a new block of counters in NVM if necessary. */
+static int nonce_take(uint32_t *dst) {
+  struct {
+    uint32_t signature;
+    uint32_t limit;
+  } rec;
+
+  if (nonce_next == nonce_limit) {
+    if (runtime_meta_read(NVM_META_STELLA, &rec, sizeof(rec)) != 0)
+      return -1;
+    if (rec.signature != NVM_META_SIG)
+      rec.limit = 0;
+    if (rec.limit >= NONCE_MAX)
+      return -1;
+
+    nonce_next = rec.limit;
+    rec.signature = NVM_META_SIG;
+    rec.limit += NONCE_BLOCK_SIZE;
+    if (runtime_meta_write(NVM_META_STELLA, &rec, sizeof(rec)) != 0)
+      return -1;
+    nonce_limit = rec.limit;
+  }
+  *dst = nonce_next++;
+  return 0;
+}
+
+/* Encrypts the plaintext in ccm_pkt into the payload of the TX packet and prepares decryption of the acknowledgment. */
+static void ccm_encrypt(uint32_t nonce) {
+  crypt.cnf.counter = nonce;
+  crypt.cnf.direction = 1;
+  memcpy(crypt.cnf.iv, &_dev_id, sizeof(_dev_id));
+  memcpy(&crypt.cnf.iv[4], iv_tag, sizeof(iv_tag));
+
+  ccm_pkt.s0 = (uint8_t)(nonce >> 16);
+  ccm_pkt.rfu = 0;
+
+  NRF_CCM->ENABLE = (CCM_ENABLE_ENABLE_Enabled << CCM_ENABLE_ENABLE_Pos);
+  NRF_CCM->MODE = (CCM_MODE_MODE_Encryption << CCM_MODE_MODE_Pos) | (CCM_MODE_LENGTH_Extended << CCM_MODE_LENGTH_Pos) |
+                  (CCM_MODE_DATARATE_1Mbit << CCM_MODE_DATARATE_Pos);
+  /* Authenticate the whole S0 byte */
+  NRF_CCM->HEADERMASK = 0xFF;
+  NRF_CCM->INPTR = (uint32_t)&ccm_pkt;
+  NRF_CCM->OUTPTR = (uint32_t)_tx_pkt_buf.data;
+  NRF_CCM->SHORTS = CCM_SHORTS_ENDKSGEN_CRYPT_Msk;
+  NRF_CCM->EVENTS_ENDKSGEN = 0;
+  NRF_CCM->EVENTS_ENDCRYPT = 0;
+  NRF_CCM->EVENTS_ERROR = 0;
+  NRF_CCM->TASKS_KSGEN = 1;
+
+  /* Takes a few ten microseconds, much less than starting the HFXO */
+  while ((NRF_CCM->EVENTS_ENDCRYPT == 0) && (NRF_CCM->EVENTS_ERROR == 0)) {
+  }
+
+  /* The acknowledgment is decrypted with the same counter in the other direction */
+  crypt.cnf.direction = 0;
+  NRF_CCM->SHORTS = 0;
+  NRF_CCM->MODE = (CCM_MODE_MODE_Decryption << CCM_MODE_MODE_Pos) | (CCM_MODE_LENGTH_Extended << CCM_MODE_LENGTH_Pos) |
+                  (CCM_MODE_DATARATE_1Mbit << CCM_MODE_DATARATE_Pos);
+  NRF_CCM->INPTR = (uint32_t)_rx_pkt_buf.data;
+  NRF_CCM->OUTPTR = (uint32_t)&ccm_pkt;
+  NRF_CCM->EVENTS_ENDKSGEN = 0;
+  NRF_CCM->EVENTS_ENDCRYPT = 0;
+  NRF_CCM->EVENTS_ERROR = 0;
+}
+
+/* Waits for decryption of the acknowledgment to complete and checks its integrity. */
+static riotee_rc_t ccm_decrypt(uint8_t **payload, size_t *payload_size) {
+  size_t rx_size = _rx_pkt_buf.len - sizeof(riotee_stella_pkt_header_t);
+  riotee_rc_t rc = RIOTEE_ERR_STELLA_INVALIDACK;
+
+  while ((NRF_CCM->EVENTS_ENDCRYPT == 0) && (NRF_CCM->EVENTS_ERROR == 0)) {
+  }
+
+  /* Encrypted acknowledgment must contain the CCM header and its length must be consistent */
+  if ((NRF_CCM->EVENTS_ENDCRYPT == 1) && (rx_size >= 3) && (_rx_pkt_buf.data[1] == rx_size - 3)) {
+    /* Like in BLE, empty packets are neither encrypted nor authenticated */
+    if (rx_size == 3) {
+      *payload_size = 0;
+      rc = RIOTEE_SUCCESS;
+    } else if ((rx_size >= 3 + 4) && (NRF_CCM->MICSTATUS == CCM_MICSTATUS_MICSTATUS_CheckPassed)) {
+      *payload = ccm_pkt.data;
+      *payload_size = ccm_pkt.len;
+      rc = RIOTEE_SUCCESS;
+    }
+  }
+  NRF_CCM->ENABLE = 0;
+  return rc;
+}
+
+/* Converts a number of ticks on the basestation clock to ticks on the local clock and vice versa. */
+static inline int64_t local2net(int64_t ticks) {
+  return ticks + (ticks * sync_state.drift_ppm) / 1000000;
+}
+
+static inline int64_t net2local(int64_t ticks) {
+  return ticks - (ticks * sync_state.drift_ppm) / 1000000;
+}
+
+static inline bool sync_valid(void) {
+  return sync_state.valid && (sync_state.n_reset == runtime_stats.n_reset);
+}
+
+/* Updates the clock model with the sync information received at local time t_local */
+static void process_sync(riotee_stella_sync_t *sync, uint64_t t_local) {
+  /* Timestamp refers to the start of the acknowledgment, but we captured the time at its end. */
+  uint32_t airtime_us = (1 + 3 + 1 + _rx_pkt_buf.len + 3) * 8;
+  t_local -= (airtime_us * 32768UL) / 1000000UL;
+
+  if (sync_valid()) {
+    int64_t dt_local = t_local - sync_state.t_local;
+    /* Cast handles wrap-around of the 32-bit basestation time */
+    int64_t dt_net = (int32_t)(sync->time - sync_state.sync.time);
+    /* Only update drift estimate over reasonably long intervals to limit the impact of timestamp resolution */
+    if (dt_local > 32768) {
+      int32_t drift_ppm = ((dt_net - dt_local) * 1000000) / dt_local;
+      /* Exponential smoothing with factor 1/4 */
+      sync_state.drift_ppm += (drift_ppm - sync_state.drift_ppm) / 4;
+    }
+  } else {
+    sync_state.drift_ppm = 0;
+  }
+  memcpy(&sync_state.sync, sync, sizeof(riotee_stella_sync_t));
+  sync_state.t_local = t_local;
+  sync_state.n_reset = runtime_stats.n_reset;
+  sync_state.valid = true;
+}
+
+riotee_rc_t riotee_stella_time_now(uint32_t *dst) {
+  if (!sync_valid())
+    return RIOTEE_ERR_STELLA_NOSYNC;
+
+  *dst = sync_state.sync.time + local2net(timing_ticks() - sync_state.t_local);
+  return RIOTEE_SUCCESS;
+}
+
+riotee_rc_t riotee_stella_wait_slot(void) {
+  if (!sync_valid() || (sync_state.sync.slot == RIOTEE_STELLA_SLOT_NONE) || (sync_state.sync.n_slots == 0))
+    return RIOTEE_ERR_STELLA_NOSYNC;
+
+  int64_t frame_ticks = (int64_t)sync_state.sync.n_slots * sync_state.sync.slot_ticks;
+  int64_t elapsed = local2net(timing_ticks() - sync_state.t_local);
+  int64_t phase = (sync_state.sync.frame_phase + elapsed) % frame_ticks;
+  int64_t slot_start = (int64_t)sync_state.sync.slot * sync_state.sync.slot_ticks;
+
+  int64_t delta = slot_start - phase;
+  while (delta < SLOT_MIN_LEAD_TICKS)
+    delta += frame_ticks;
+
+  uint64_t t_wake = timing_ticks() + net2local(delta);
+  for (;;) {
+    uint64_t now = timing_ticks();
+    uint64_t remaining;
+    riotee_rc_t rc;
+
+    if (now >= t_wake)
+      return RIOTEE_SUCCESS;
+    remaining = t_wake - now;
+    /* The RTC may miss a compare value that is only a tick or two ahead, which would oversleep by a full wrap */
+    if (remaining < SLOT_MIN_LEAD_TICKS) {
+      while (timing_ticks() < t_wake) {
+      }
+      return RIOTEE_SUCCESS;
+    }
+    /* Leave at least SLOT_MIN_LEAD_TICKS for the last chunk */
+    if (remaining > SLEEP_MAX_TICKS)
+      remaining = (remaining - SLEEP_MAX_TICKS < SLOT_MIN_LEAD_TICKS) ? remaining - SLOT_MIN_LEAD_TICKS : SLEEP_MAX_TICKS;
+    rc = riotee_sleep_ticks(remaining);
+    if (rc != RIOTEE_SUCCESS)
+      return rc;
+  }
+}
+
 riotee_rc_t riotee_stella_transceive(uint8_t *rx_buf, size_t rx_size, void *tx_data, size_t tx_size) {
-  if (tx_size > RIOTEE_STELLA_MAX_DATA)
-    return RIOTEE_ERR_OVERFLOW;
+  uint32_t nonce;
+
+  if (crypt.enabled) {
+    if (tx_size > RIOTEE_STELLA_MAX_DATA_ENC)
+      return RIOTEE_ERR_OVERFLOW;
+
+    if (nonce_take(&nonce) != 0)
+      return RIOTEE_ERR_STELLA_NONCE;
+
+    memcpy(ccm_pkt.data, tx_data, tx_size);
+    ccm_pkt.len = tx_size;
+    ccm_encrypt(nonce);
+    /* CCM does not add a MIC to empty packets, so take the length from its output */
+    _tx_pkt_buf.len = sizeof(riotee_stella_pkt_header_t) + 3 + _tx_pkt_buf.data[1];
 
-  memcpy(_tx_pkt_buf.data, tx_data, tx_size);
-  _tx_pkt_buf.len = sizeof(riotee_stella_pkt_header_t) + tx_size;
+    /* Packet ID carries the lower bits of the packet counter used for encryption. */
+    _tx_pkt_buf.hdr.pkt_id = (uint16_t)nonce;
+  } else {
+    if (tx_size > RIOTEE_STELLA_MAX_DATA)
+      return RIOTEE_ERR_OVERFLOW;
 
-  /* Packet ID is truncated packet counter. */
-  _tx_pkt_buf.hdr.pkt_id = (uint16_t)pkt_counter;
+    memcpy(_tx_pkt_buf.data, tx_data, tx_size);
+    _tx_pkt_buf.len = sizeof(riotee_stella_pkt_header_t) + tx_size;
+
+    /* Packet ID is truncated packet counter. */
+    _tx_pkt_buf.hdr.pkt_id = (uint16_t)pkt_counter;
+  }
 
   /* Set correct device ID */
   _tx_pkt_buf.hdr.dev_id = _dev_id;
 
   riotee_rc_t rc = _transceive(&_rx_pkt_buf, &_tx_pkt_buf);
+  link_update(rc);
+
+  size_t payload_size = _rx_pkt_buf.len - sizeof(riotee_stella_pkt_header_t);
+  uint8_t *payload = _rx_pkt_buf.data;
+
+  if (crypt.enabled) {
+    if (rc == RIOTEE_SUCCESS)
+      rc = ccm_decrypt(&payload, &payload_size);
+    else
+      NRF_CCM->ENABLE = 0;
+  }
 
   if (rc != RIOTEE_SUCCESS)
     return rc;
 
-  size_t payload_size = _rx_pkt_buf.len - sizeof(riotee_stella_pkt_header_t);
+  /* Acknowledgments on the sync address carry sync information in front of the payload */
+  if (rx_match == LA_DOWNLINK_SYNC_IDX) {
+    if (payload_size < sizeof(riotee_stella_sync_t))
+      return RIOTEE_ERR_STELLA_INVALIDACK;
+
+    process_sync((riotee_stella_sync_t *)payload, t_rx);
+    payload += sizeof(riotee_stella_sync_t);
+    payload_size -= sizeof(riotee_stella_sync_t);
+  }
 
   if (rx_size < payload_size)
     return RIOTEE_ERR_OVERFLOW;
 
-  memcpy(rx_buf, _rx_pkt_buf.data, payload_size);
+  memcpy(rx_buf, payload, payload_size);
 
   return payload_size;
 }
@@ -296,6 +681,15 @@ riotee_rc_t riotee_stella_receive(uint8_t *rx_buf, size_t rx_size) {
   return riotee_stella_transceive(rx_buf, rx_size, NULL, 0);
 }
 
+void riotee_stella_set_key(const uint8_t *key) {
+  if (key == NULL) {
+    crypt.enabled = false;
+    return;
+  }
+  memcpy(crypt.cnf.key, key, RIOTEE_STELLA_KEY_SIZE);
+  crypt.enabled = true;
+}
+
 void riotee_stella_set_id(uint32_t dev_id) {
   _dev_id = dev_id;
 }
@@ -306,4 +700,36 @@ uint32_t riotee_stella_get_id(void) {
 
 unsigned int riotee_stella_get_packet_counter(void) {
   return pkt_counter;
-}
\ No newline at end of file
+}
+void riotee_stella_get_link(riotee_stella_link_t *dst) {
+  dst->rssi_dbm = link.rssi_avg_q4 >> 4;
+  dst->rssi_last_dbm = link.rssi_last;
+  dst->txpower_dbm = txpower_lut[link.txpower_idx];
+  dst->n_miss = link.n_miss;
+  dst->txpower_auto = link.txpower_auto;
+}
+
+riotee_rc_t riotee_stella_set_txpower(int txpower_dbm) {
+  for (unsigned int i = 0; i < N_TXPOWER; i++) {
+    if (txpower_lut[i] == txpower_dbm) {
+      link.txpower_idx = i;
+      link.txpower_auto = false;
+      link.initialized = true;
+      return RIOTEE_SUCCESS;
+    }
+  }
+  return RIOTEE_ERR_INVALIDARG;
+}
+
+riotee_rc_t riotee_stella_set_txpower_auto(int target_rssi_dbm, int bs_txpower_dbm) {
+  if ((target_rssi_dbm < SENSITIVITY_DBM) || (target_rssi_dbm > 0))
+    return RIOTEE_ERR_INVALIDARG;
+  if ((bs_txpower_dbm < BS_TXPOWER_MIN_DBM) || (bs_txpower_dbm > BS_TXPOWER_MAX_DBM))
+    return RIOTEE_ERR_INVALIDARG;
+
+  link.target_rssi = target_rssi_dbm;
+  link.bs_txpower = bs_txpower_dbm;
+  link.txpower_auto = true;
+  link.n_ack = 0;
+  return RIOTEE_SUCCESS;
+}
@@ -104,3 +104,26 @@ void riotee_thresholds_high_set(thr_high_t thr) {
 
   gpio_set(PIN_THRCTL_H1, gpio_states[1]);
 }
+
+static gpio_state_t gpio_get(uint32_t pin) {
+  NRF_GPIO_Type *reg = nrf_gpio_pin_port_decode(&pin);
+
+  if ((reg->PIN_CNF[pin] & GPIO_PIN_CNF_DIR_Msk) != (GPIO_PIN_CNF_DIR_Output << GPIO_PIN_CNF_DIR_Pos))
+    return Z;
+  return (reg->OUT & (1 << pin)) ? HIGH : LOW;
+}
+
+/* The threshold enums encode the pin states as state(x0) + 3 * state(x1). Decoding the pins keeps the getters correct
+ * regardless of when and by whom the thresholds were set. */
+float riotee_thresholds_low_get(void) {
+  unsigned int s0 = gpio_get(PIN_THRCTL_L0);
+  unsigned int s1 = gpio_get(PIN_THRCTL_L1);
+  /* Exact for the four settings of thr_low_t, nominal if a pin is High-Z */
+  return 2.5f + 0.5f * s0 + 0.3f * s1;
+}
+
+float riotee_thresholds_high_get(void) {
+  /* Indexed by thr_high_t */
+  static const float v_lut[] = {3.0f, 3.4f, 4.0f, 3.2f, 3.8f, 4.4f, 3.6f, 4.2f, 4.6f};
+  return v_lut[gpio_get(PIN_THRCTL_H0) + 3 * gpio_get(PIN_THRCTL_H1)];
+}
@@ -107,6 +107,22 @@ void riotee_timing_init(void) {
   n_reset = runtime_stats.n_reset;
 }
 
+uint64_t timing_ticks(void) {
+  uint32_t counter, overflows;
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+  counter = NRF_RTC0->COUNTER;
+  overflows = overflow_counter;
+  /* Overflow may be pending if we are called with interrupts masked */
+  if (NRF_RTC0->EVENTS_OVRFLW == 1) {
+    counter = NRF_RTC0->COUNTER;
+    overflows++;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return (((uint64_t)overflows) << 24) + counter;
+}
+
 riotee_rc_t riotee_timing_now(uint64_t *dst) {
   riotee_rc_t rc;
 
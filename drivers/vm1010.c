@@ -18,7 +18,8 @@ static unsigned int pin_dout;
 riotee_adc_cfg_t adc_cfg = {.acq_time = RIOTEE_ADC_ACQTIME_3US,
                             .gain = RIOTEE_ADC_GAIN2,
                             .oversampling = RIOTEE_ADC_OVERSAMPLE_DISABLED,
-                            .reference = RIOTEE_ADC_REFERENCE_INTERNAL};
+                            .reference = RIOTEE_ADC_REFERENCE_INTERNAL,
+                            .pacing = RIOTEE_ADC_PACING_HW};
 
 int vm1010_init(vm1010_cfg_t *cfg) {
   int rc;
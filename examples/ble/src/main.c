@@ -1,6 +1,8 @@
 
 #include "riotee.h"
+#include "riotee_adc.h"
 #include "riotee_ble.h"
+#include "riotee_duty.h"
 #include "riotee_timing.h"
 
 const uint8_t adv_address[] = {0x01, 0xEE, 0xC0, 0xFF, 0x03, 0x02};
@@ -10,7 +12,10 @@ static struct {
   unsigned int counter;
 } ble_data;
 
+static riotee_duty_t duty;
+
 void lateinit(void) {
+  riotee_adc_init();
   riotee_ble_init();
 }
 
@@ -21,13 +26,14 @@ int main() {
                                   .data = &ble_data,
                                   .data_len = sizeof(ble_data),
                                   .manufacturer_id = RIOTEE_BLE_ADV_MNF_NORDIC};
+  riotee_duty_cfg_t duty_cfg = {.min_period_ms = 250, .max_period_ms = 10000, .target_soc = 0.5f};
   riotee_ble_adv_cfg(&adv_cfg);
+  riotee_duty_init(&duty, &duty_cfg);
   ble_data.counter = 0;
   for (;;) {
-    riotee_wait_cap_charged();
     riotee_ble_advertise(ADV_CH_ALL);
     ble_data.counter++;
-    /* Sleep at least 250ms before next advertising round */
-    riotee_sleep_ms(250);
+    /* Sleep at least 250ms before next advertising round, longer if harvesting cannot keep up */
+    riotee_duty_wait(&duty);
   }
 }
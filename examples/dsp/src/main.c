@@ -46,7 +46,8 @@ int main(void) {
                               .input_pos = RIOTEE_ADC_INPUT_A0,
                               .oversampling = RIOTEE_ADC_OVERSAMPLE_DISABLED,
                               .n_samples = FFT_SIZE,
-                              .sample_interval_ticks32 = 8};
+                              .sample_interval_ticks32 = 8,
+                              .pacing = RIOTEE_ADC_PACING_HW};
 
   arm_rfft_fast_init_f32(&fft_inst, FFT_SIZE);
 
@@ -0,0 +1,54 @@
+#include "riotee.h"
+#include "riotee_filter.h"
+#include "riotee_stella.h"
+#include "riotee_timing.h"
+
+#include "shtc3.h"
+#include "printf.h"
+
+enum { CH_TEMP, CH_HUMIDITY, N_CHANNELS };
+
+static const riotee_filter_cfg_t filter_cfg[N_CHANNELS] = {
+    /* Report temperature changes of more than 0.2°C or fast changes of more than 0.05°C per second */
+    [CH_TEMP] = {.abs_delta = 0.2f, .max_rate = 0.05f, .max_silence_ms = 10 * 60 * 1000},
+    /* Report relative changes of humidity of more than 5% */
+    [CH_HUMIDITY] = {.rel_delta = 0.05f, .max_silence_ms = 10 * 60 * 1000},
+};
+
+static riotee_filter_t filter;
+
+void earlyinit(void) {
+  /* Call this early to put SHTC3 into low power mode */
+  shtc3_init();
+}
+
+void bootstrap(void) {
+  riotee_filter_init(&filter, filter_cfg, N_CHANNELS);
+}
+
+void lateinit(void) {
+  riotee_stella_init();
+}
+
+int main(void) {
+  shtc3_res_t th_result;
+  riotee_rc_t rc;
+
+  for (;;) {
+    riotee_sleep_ms(5000);
+    riotee_wait_cap_charged();
+    if (shtc3_read(&th_result) != 0)
+      continue;
+
+    float values[N_CHANNELS] = {[CH_TEMP] = th_result.temp, [CH_HUMIDITY] = th_result.humidity};
+    if (riotee_filter_update(&filter, values) == 0)
+      continue;
+
+    /* Send both readings if any of them changed */
+    rc = riotee_stella_send(&th_result, sizeof(shtc3_res_t));
+    if (rc == RIOTEE_SUCCESS)
+      riotee_filter_commit(&filter, RIOTEE_FILTER_ALL);
+    else
+      printf("Error %d\r\n", rc);
+  }
+}
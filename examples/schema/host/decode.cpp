@@ -0,0 +1,38 @@
+/* Decodes payloads of the schema example from hex strings on stdin, e.g. the data field printed by the gateway. */
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "payload.hpp"
+
+static bool parse_hex(const std::string &str, std::vector<uint8_t> &dst) {
+  if (str.size() % 2)
+    return false;
+  dst.clear();
+  for (size_t i = 0; i < str.size(); i += 2) {
+    try {
+      dst.push_back((uint8_t)std::stoul(str.substr(i, 2), nullptr, 16));
+    } catch (...) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::string line;
+  std::vector<uint8_t> data;
+
+  while (std::getline(std::cin, line)) {
+    if (line.empty())
+      continue;
+    if (!parse_hex(line, data) || data.size() < Payload::size) {
+      std::fprintf(stderr, "Expected at least %zu bytes of hex data: %s\n", Payload::size, line.c_str());
+      continue;
+    }
+    Payload::visit(data.data(), [](const char *name, double value) { std::printf("%s=%g ", name, value); });
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef __PAYLOAD_HPP_
+#define __PAYLOAD_HPP_
+
+#include "riotee_schema.hpp"
+
+namespace sch = riotee::schema;
+
+/* -40°C to 62.35°C in steps of 0.05°C */
+struct Temperature : sch::Fixed<11, std::ratio<1, 20>, std::ratio<-40>> {
+  static constexpr char name[] = "temperature";
+};
+
+/* 0% to 127% in steps of 1% */
+struct Humidity : sch::Fixed<7> {
+  static constexpr char name[] = "humidity";
+};
+
+/* Raw 12-bit ADC reading of the capacitor voltage */
+struct VcapRaw : sch::UInt<12> {
+  static constexpr char name[] = "vcap_raw";
+};
+
+/* Wraps around after 1024 packets */
+struct Counter : sch::UInt<10> {
+  static constexpr char name[] = "counter";
+};
+
+using Payload = sch::Schema<Temperature, Humidity, VcapRaw, Counter>;
+
+static_assert(Payload::size == 5, "Payload should fit into 5 bytes");
+
+#endif /* __PAYLOAD_HPP_ */
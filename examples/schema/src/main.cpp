@@ -0,0 +1,37 @@
+#include "riotee.h"
+#include "riotee_adc.h"
+#include "riotee_stella.h"
+#include "riotee_timing.h"
+
+#include "shtc3.h"
+#include "payload.hpp"
+#include "printf.h"
+
+static unsigned int counter = 0;
+
+void earlyinit(void) {
+  /* Call this early to put SHTC3 into low power mode */
+  shtc3_init();
+}
+
+void lateinit(void) {
+  riotee_adc_init();
+  riotee_stella_init();
+}
+
+int main(void) {
+  shtc3_res_t th_result;
+  riotee_rc_t rc;
+
+  for (;;) {
+    riotee_wait_cap_charged();
+    if (shtc3_read(&th_result) != 0)
+      continue;
+
+    Payload::Buffer buf = Payload::pack(th_result.temp, th_result.humidity, riotee_adc_read(RIOTEE_ADC_INPUT_VCAP),
+                                        counter++);
+    rc = riotee_stella_send(buf.data(), buf.size());
+    if (rc < 0)
+      printf("Error %d\r\n", rc);
+  }
+}
@@ -0,0 +1,163 @@
+#include "basestation.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace stella {
+
+namespace {
+/* FNV-1a hash of a payload */
+uint32_t digest(const std::vector<uint8_t> &data) {
+  uint32_t hash = 2166136261u;
+  for (uint8_t b : data)
+    hash = (hash ^ b) * 16777619u;
+  return hash;
+}
+}  // namespace
+
+std::optional<size_t> Basestation::History::find(uint16_t pkt_id, uint32_t digest) const {
+  for (size_t i = 0; i < kSize; i++) {
+    if (entries[i].used && (entries[i].pkt_id == pkt_id) && (entries[i].digest == digest))
+      return i;
+  }
+  return std::nullopt;
+}
+
+size_t Basestation::History::insert(uint16_t pkt_id, uint32_t digest) {
+  size_t idx = next;
+  entries[idx] = {pkt_id, digest, true};
+  next = (next + 1) % kSize;
+  return idx;
+}
+
+Basestation::Basestation(BasestationConfig cfg) : cfg_(std::move(cfg)) {}
+
+Basestation::Device &Basestation::device(uint32_t dev_id) {
+  auto it = devices_.find(dev_id);
+  if (it != devices_.end())
+    return it->second;
+
+  Device &dev = devices_[dev_id];
+  /* Slots are assigned in the order in which devices show up */
+  if (n_assigned_ < cfg_.n_slots)
+    dev.slot = n_assigned_++;
+
+  auto key = cfg_.keys.find(dev_id);
+  if (key != cfg_.keys.end())
+    dev.cipher = std::make_unique<Cipher>(dev_id, key->second);
+  return dev;
+}
+
+Sync Basestation::sync(const Device &dev, uint32_t now) const {
+  Sync s;
+  s.time = now;
+  s.frame_phase = now % (static_cast<uint32_t>(cfg_.n_slots) * cfg_.slot_ticks);
+  s.slot = dev.slot;
+  s.n_slots = cfg_.n_slots;
+  s.slot_ticks = cfg_.slot_ticks;
+  return s;
+}
+
+std::vector<uint8_t> Basestation::downlink(const Device &dev, uint32_t now, const std::vector<uint8_t> &msg) const {
+  size_t pos = (cfg_.n_slots > 0) ? sizeof(Sync) : 0;
+  std::vector<uint8_t> data(pos + msg.size());
+  if (pos > 0) {
+    Sync s = sync(dev, now);
+    std::memcpy(data.data(), &s, sizeof(Sync));
+  }
+  std::copy(msg.begin(), msg.end(), data.begin() + pos);
+  return data;
+}
+
+size_t Basestation::max_downlink(uint32_t dev_id) const {
+  size_t max = cfg_.keys.count(dev_id) ? kMaxDataEnc : kMaxData;
+  if (cfg_.n_slots > 0)
+    max -= sizeof(Sync);
+  return max;
+}
+
+bool Basestation::post(uint32_t dev_id, std::vector<uint8_t> payload) {
+  if (payload.size() > max_downlink(dev_id))
+    return false;
+
+  Device &dev = device(dev_id);
+  if (dev.mailbox.size() >= cfg_.mailbox_size)
+    return false;
+  dev.mailbox.push_back(std::move(payload));
+  return true;
+}
+
+std::optional<Ack> Basestation::handle(const Frame &frame, uint32_t now) {
+  uint32_t dev_id = frame.hdr.dev_id;
+  Device &dev = device(dev_id);
+
+  std::vector<uint8_t> payload;
+  if (dev.cipher) {
+    auto plaintext = dev.cipher->open(frame);
+    if (!plaintext) {
+      stats_.n_invalid++;
+      return std::nullopt;
+    }
+    payload = std::move(*plaintext);
+  } else {
+    payload = frame.data;
+  }
+
+  stats_.n_rx++;
+  stats_.air_bytes += air_bytes(sizeof(PacketHeader) + frame.data.size());
+
+  Ack ack;
+  ack.address = (cfg_.n_slots > 0) ? Address::kDownlinkSync : Address::kDownlink;
+  ack.frame.hdr.dev_id = dev_id;
+  ack.frame.hdr.ack_id = frame.hdr.pkt_id;
+
+  /* Acknowledge a duplicate with the same packet ID and message, so that a downlink message is not lost or delivered
+   * twice. The sync information is rebuilt, as the cached one is outdated. */
+  uint32_t hash = digest(frame.data);
+  if (auto idx = dev.history.find(frame.hdr.pkt_id, hash)) {
+    Reply &reply = dev.replies[*idx];
+    stats_.n_duplicate++;
+    ack.frame.hdr.pkt_id = reply.pkt_id;
+    if (!dev.cipher) {
+      ack.frame.data = downlink(dev, now, reply.msg);
+    } else {
+      /* The downlink counter is derived from the uplink frame, so sealing a new plaintext would reuse the CCM nonce.
+       * Empty packets are not encrypted: acknowledge without sync and deliver the message with the next new uplink. */
+      ack.address = Address::kDownlink;
+      ack.frame.data = dev.cipher->seal(Cipher::counter(frame), {});
+      if (!reply.msg.empty()) {
+        stats_.payload_bytes -= reply.msg.size();
+        stats_.n_downlink--;
+        dev.mailbox.push_front(std::move(reply.msg));
+        reply.msg.clear();
+      }
+    }
+    stats_.air_bytes += air_bytes(sizeof(PacketHeader) + ack.frame.data.size());
+    return ack;
+  }
+
+  stats_.payload_bytes += payload.size();
+  if (uplink_handler_)
+    uplink_handler_(dev_id, frame.hdr.pkt_id, payload);
+
+  Reply reply;
+  if (!dev.mailbox.empty()) {
+    reply.msg = std::move(dev.mailbox.front());
+    stats_.payload_bytes += reply.msg.size();
+    stats_.n_downlink++;
+    dev.mailbox.pop_front();
+  }
+  reply.pkt_id = dev.pkt_id++;
+
+  ack.frame.hdr.pkt_id = reply.pkt_id;
+  if (dev.cipher)
+    ack.frame.data = dev.cipher->seal(Cipher::counter(frame), downlink(dev, now, reply.msg));
+  else
+    ack.frame.data = downlink(dev, now, reply.msg);
+
+  stats_.air_bytes += air_bytes(sizeof(PacketHeader) + ack.frame.data.size());
+  dev.replies[dev.history.insert(frame.hdr.pkt_id, hash)] = std::move(reply);
+  return ack;
+}
+
+}  // namespace stella
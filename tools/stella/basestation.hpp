@@ -0,0 +1,118 @@
+// Transport-independent core of the host basestation: acknowledges uplink frames, filters duplicates and delivers
+// queued downlink messages in the acknowledgments.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "stella.hpp"
+
+namespace stella {
+
+struct BasestationConfig {
+  /* Maximum number of downlink messages queued per device */
+  size_t mailbox_size = 16;
+  /* Number of slots per frame. 0 disables sync information in acknowledgments. */
+  uint16_t n_slots = 0;
+  /* Length of one slot in ticks of a 32kHz clock */
+  uint16_t slot_ticks = 328;
+  /* Keys of devices whose traffic is encrypted */
+  std::unordered_map<uint32_t, Key> keys;
+};
+
+struct BasestationStats {
+  uint64_t n_rx = 0;
+  uint64_t n_duplicate = 0;
+  uint64_t n_invalid = 0;
+  uint64_t n_downlink = 0;
+  /* Payload bytes delivered in both directions and bytes sent on air including preamble, address and CRC */
+  uint64_t payload_bytes = 0;
+  uint64_t air_bytes = 0;
+};
+
+/* Response to an uplink frame */
+struct Ack {
+  Address address;
+  Frame frame;
+};
+
+class Basestation {
+ public:
+  /* Receives the payload of every new uplink frame */
+  using UplinkHandler = std::function<void(uint32_t dev_id, uint16_t pkt_id, const std::vector<uint8_t> &payload)>;
+
+  explicit Basestation(BasestationConfig cfg);
+
+  void on_uplink(UplinkHandler handler) { uplink_handler_ = std::move(handler); }
+
+  /* Processes a frame received on the uplink address at basestation time 'now' (32kHz ticks) and returns the
+   * acknowledgment, or nothing if the frame must not be acknowledged. */
+  std::optional<Ack> handle(const Frame &frame, uint32_t now);
+
+  /* Queues a downlink message for a device. Returns false if the message is too big or the mailbox is full. */
+  bool post(uint32_t dev_id, std::vector<uint8_t> payload);
+
+  /* Maximum size of a downlink message for a device */
+  size_t max_downlink(uint32_t dev_id) const;
+
+  size_t n_devices() const { return devices_.size(); }
+  const BasestationStats &stats() const { return stats_; }
+
+  /* Bytes on air for a frame of the given length: preamble, address, length byte, payload and CRC */
+  static constexpr size_t air_bytes(size_t len) { return 1 + 3 + 1 + len + 3; }
+
+ private:
+  /* Remembers recently received packets to detect duplicates. A repeated packet ID with a different payload is a new
+   * packet from a device that rolled back to an older checkpoint. */
+  struct History {
+    static constexpr size_t kSize = 32;
+    struct Entry {
+      uint16_t pkt_id;
+      uint32_t digest;
+      bool used;
+    };
+    std::array<Entry, kSize> entries{};
+    size_t next = 0;
+
+    /* Returns the index of a matching entry */
+    std::optional<size_t> find(uint16_t pkt_id, uint32_t digest) const;
+    size_t insert(uint16_t pkt_id, uint32_t digest);
+  };
+
+  /* Packet ID and downlink message of an acknowledgment */
+  struct Reply {
+    uint16_t pkt_id = 0;
+    std::vector<uint8_t> msg;
+  };
+
+  struct Device {
+    std::deque<std::vector<uint8_t>> mailbox;
+    History history;
+    /* Acknowledgments sent for the packets in the history, rebuilt for duplicates */
+    std::array<Reply, History::kSize> replies;
+    uint16_t slot = kSlotNone;
+    /* ID of the next acknowledgment sent to the device */
+    uint16_t pkt_id = 0;
+    std::unique_ptr<Cipher> cipher;
+  };
+
+  Device &device(uint32_t dev_id);
+  Sync sync(const Device &dev, uint32_t now) const;
+  /* Downlink payload of an acknowledgment: sync information, if enabled, followed by the message */
+  std::vector<uint8_t> downlink(const Device &dev, uint32_t now, const std::vector<uint8_t> &msg) const;
+
+  BasestationConfig cfg_;
+  std::unordered_map<uint32_t, Device> devices_;
+  uint16_t n_assigned_ = 0;
+  UplinkHandler uplink_handler_;
+  BasestationStats stats_;
+};
+
+}  // namespace stella
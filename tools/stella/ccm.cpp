@@ -0,0 +1,161 @@
+#include "ccm.hpp"
+
+#include <cstring>
+
+namespace stella {
+
+namespace {
+
+const uint8_t kSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9,
+    0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f,
+    0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, 0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07,
+    0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3,
+    0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58,
+    0xcf, 0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3,
+    0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec, 0x5f,
+    0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, 0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+    0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac,
+    0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a,
+    0xae, 0x08, 0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, 0x70,
+    0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+    0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42,
+    0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+inline uint8_t xtime(uint8_t x) {
+  return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+}  // namespace
+
+Aes128::Aes128(const Key &key) {
+  std::memcpy(round_keys_.data(), key.data(), key.size());
+  uint8_t rcon = 0x01;
+  for (size_t i = 16; i < round_keys_.size(); i += 4) {
+    uint8_t t[4];
+    std::memcpy(t, &round_keys_[i - 4], 4);
+    if (i % 16 == 0) {
+      uint8_t first = t[0];
+      t[0] = kSbox[t[1]] ^ rcon;
+      t[1] = kSbox[t[2]];
+      t[2] = kSbox[t[3]];
+      t[3] = kSbox[first];
+      rcon = xtime(rcon);
+    }
+    for (size_t j = 0; j < 4; j++)
+      round_keys_[i + j] = round_keys_[i - 16 + j] ^ t[j];
+  }
+}
+
+Block Aes128::encrypt(const Block &in) const {
+  Block s;
+  for (size_t i = 0; i < 16; i++)
+    s[i] = in[i] ^ round_keys_[i];
+
+  for (size_t round = 1; round <= 10; round++) {
+    /* SubBytes and ShiftRows; the state is stored column by column */
+    Block t;
+    for (size_t c = 0; c < 4; c++)
+      for (size_t r = 0; r < 4; r++)
+        t[4 * c + r] = kSbox[s[4 * ((c + r) % 4) + r]];
+
+    /* MixColumns, except in the last round */
+    if (round < 10) {
+      for (size_t c = 0; c < 4; c++) {
+        uint8_t *col = &t[4 * c];
+        uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+        uint8_t first = col[0];
+        col[0] ^= all ^ xtime(col[0] ^ col[1]);
+        col[1] ^= all ^ xtime(col[1] ^ col[2]);
+        col[2] ^= all ^ xtime(col[2] ^ col[3]);
+        col[3] ^= all ^ xtime(col[3] ^ first);
+      }
+    }
+    for (size_t i = 0; i < 16; i++)
+      s[i] = t[i] ^ round_keys_[16 * round + i];
+  }
+  return s;
+}
+
+Nonce make_nonce(uint64_t counter, bool direction, const std::array<uint8_t, 8> &iv) {
+  Nonce nonce;
+  for (size_t i = 0; i < 5; i++)
+    nonce[i] = static_cast<uint8_t>(counter >> (8 * i));
+  /* Counter has 39 bits, the most significant bit of the fifth byte is the direction */
+  nonce[4] = (nonce[4] & 0x7F) | (direction ? 0x80 : 0x00);
+  std::memcpy(&nonce[5], iv.data(), iv.size());
+  return nonce;
+}
+
+Block Ccm::mic(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &plaintext) const {
+  /* B0: flags (Adata, M=4, L=2), nonce and length of the message */
+  Block b{};
+  b[0] = 0x40 | (((kMicSize - 2) / 2) << 3) | (2 - 1);
+  std::memcpy(&b[1], nonce.data(), nonce.size());
+  b[14] = static_cast<uint8_t>(plaintext.size() >> 8);
+  b[15] = static_cast<uint8_t>(plaintext.size());
+  Block x = aes_.encrypt(b);
+
+  /* B1: length of the additional data followed by the additional data */
+  b.fill(0);
+  b[1] = 1;
+  b[2] = aad;
+  for (size_t i = 0; i < 16; i++)
+    x[i] ^= b[i];
+  x = aes_.encrypt(x);
+
+  for (size_t offset = 0; offset < plaintext.size(); offset += 16) {
+    for (size_t i = 0; (i < 16) && (offset + i < plaintext.size()); i++)
+      x[i] ^= plaintext[offset + i];
+    x = aes_.encrypt(x);
+  }
+  return x;
+}
+
+/* Applies the keystream starting with counter block 1 to data and encrypts the MIC with counter block 0 */
+void Ccm::ctr(const Nonce &nonce, std::vector<uint8_t> &data) const {
+  Block a{};
+  a[0] = 2 - 1;
+  std::memcpy(&a[1], nonce.data(), nonce.size());
+
+  size_t payload_size = data.size() - kMicSize;
+  for (size_t offset = 0; offset < payload_size; offset += 16) {
+    uint16_t i_block = static_cast<uint16_t>(offset / 16 + 1);
+    a[14] = static_cast<uint8_t>(i_block >> 8);
+    a[15] = static_cast<uint8_t>(i_block);
+    Block s = aes_.encrypt(a);
+    for (size_t i = 0; (i < 16) && (offset + i < payload_size); i++)
+      data[offset + i] ^= s[i];
+  }
+  a[14] = 0;
+  a[15] = 0;
+  Block s0 = aes_.encrypt(a);
+  for (size_t i = 0; i < kMicSize; i++)
+    data[payload_size + i] ^= s0[i];
+}
+
+std::vector<uint8_t> Ccm::encrypt(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &plaintext) const {
+  Block tag = mic(nonce, aad, plaintext);
+  std::vector<uint8_t> out(plaintext);
+  out.insert(out.end(), tag.begin(), tag.begin() + kMicSize);
+  ctr(nonce, out);
+  return out;
+}
+
+bool Ccm::decrypt(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &ciphertext,
+                  std::vector<uint8_t> &plaintext) const {
+  if (ciphertext.size() < kMicSize)
+    return false;
+
+  std::vector<uint8_t> buf(ciphertext);
+  ctr(nonce, buf);
+  plaintext.assign(buf.begin(), buf.end() - kMicSize);
+
+  Block tag = mic(nonce, aad, plaintext);
+  uint8_t diff = 0;
+  for (size_t i = 0; i < kMicSize; i++)
+    diff |= tag[i] ^ buf[plaintext.size() + i];
+  return diff == 0;
+}
+
+}  // namespace stella
@@ -0,0 +1,50 @@
+// AES-128 in CCM mode as used by the CCM peripheral of the nRF52 for encrypting Stella packets.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace stella {
+
+using Key = std::array<uint8_t, 16>;
+using Block = std::array<uint8_t, 16>;
+
+/* AES-128 block cipher, encryption direction only, which is all that CCM needs. */
+class Aes128 {
+ public:
+  explicit Aes128(const Key &key);
+  Block encrypt(const Block &in) const;
+
+ private:
+  std::array<uint8_t, 176> round_keys_;
+};
+
+/* 13 byte nonce: 39-bit packet counter, direction bit and 8 byte initialization vector */
+using Nonce = std::array<uint8_t, 13>;
+
+Nonce make_nonce(uint64_t counter, bool direction, const std::array<uint8_t, 8> &iv);
+
+/* CCM with a 4 byte MIC, 2 byte length field and a single byte of additional authenticated data, matching the nRF52
+ * CCM peripheral. */
+class Ccm {
+ public:
+  static constexpr size_t kMicSize = 4;
+
+  explicit Ccm(const Key &key) : aes_(key) {}
+
+  /* Returns ciphertext followed by the MIC. */
+  std::vector<uint8_t> encrypt(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &plaintext) const;
+  /* Returns false if the MIC does not match. */
+  bool decrypt(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &ciphertext,
+               std::vector<uint8_t> &plaintext) const;
+
+ private:
+  Block mic(const Nonce &nonce, uint8_t aad, const std::vector<uint8_t> &plaintext) const;
+  void ctr(const Nonce &nonce, std::vector<uint8_t> &data) const;
+
+  Aes128 aes_;
+};
+
+}  // namespace stella
@@ -0,0 +1,118 @@
+#include "delta.hpp"
+
+#include <algorithm>
+
+namespace stella {
+
+namespace {
+
+constexpr unsigned kMaxChannels = 4;
+constexpr unsigned kBlockSize = 8;
+constexpr unsigned kModeVarint = 0;
+constexpr unsigned kModeBitpack = 1;
+
+class Reader {
+ public:
+  Reader(const uint8_t *buf, size_t size) : buf_(buf), size_(size) {}
+
+  std::optional<uint32_t> varint() {
+    uint32_t x = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+      if (pos_ >= size_)
+        return std::nullopt;
+      uint8_t b = buf_[pos_++];
+      x |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return x;
+    }
+    return std::nullopt;
+  }
+
+  /* Reads a block of n deltas with a common bit width */
+  bool block(uint32_t *dst, unsigned n) {
+    if (pos_ >= size_)
+      return false;
+    unsigned width = buf_[pos_++];
+    if (width > 32)
+      return false;
+    uint64_t acc = 0;
+    unsigned n_acc = 0;
+    for (unsigned i = 0; i < n; i++) {
+      while (n_acc < width) {
+        if (pos_ >= size_)
+          return false;
+        acc |= (uint64_t)buf_[pos_++] << n_acc;
+        n_acc += 8;
+      }
+      dst[i] = (uint32_t)(acc & ((1ULL << width) - 1));
+      acc >>= width;
+      n_acc -= width;
+    }
+    return true;
+  }
+
+  bool done() const { return pos_ == size_; }
+
+ private:
+  const uint8_t *buf_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+int32_t unzigzag(int32_t prev, uint32_t x) {
+  uint32_t d = (x >> 1) ^ (0U - (x & 1));
+  return (int32_t)((uint32_t)prev + d);
+}
+
+}  // namespace
+
+std::optional<std::vector<DeltaFrame>> delta_decode(const uint8_t *buf, size_t size) {
+  if (size < 3)
+    return std::nullopt;
+  unsigned mode = buf[0] >> 4;
+  unsigned n_channels = buf[0] & 0x0F;
+  unsigned n_frames = buf[1] | (buf[2] << 8);
+  if ((n_channels == 0) || (n_channels > kMaxChannels) || (n_frames == 0))
+    return std::nullopt;
+  if ((mode != kModeVarint) && (mode != kModeBitpack))
+    return std::nullopt;
+
+  Reader reader(buf + 3, size - 3);
+  std::vector<DeltaFrame> frames;
+  DeltaFrame frame(n_channels, 0);
+
+  for (auto &value : frame) {
+    auto x = reader.varint();
+    if (!x)
+      return std::nullopt;
+    value = unzigzag(0, *x);
+  }
+  frames.push_back(frame);
+
+  size_t n_deltas = (size_t)(n_frames - 1) * n_channels;
+  std::vector<uint32_t> deltas(n_deltas);
+  if (mode == kModeVarint) {
+    for (auto &delta : deltas) {
+      auto x = reader.varint();
+      if (!x)
+        return std::nullopt;
+      delta = *x;
+    }
+  } else {
+    for (size_t i = 0; i < n_deltas; i += kBlockSize) {
+      if (!reader.block(&deltas[i], std::min<size_t>(kBlockSize, n_deltas - i)))
+        return std::nullopt;
+    }
+  }
+  if (!reader.done())
+    return std::nullopt;
+
+  for (size_t i = 0; i < n_deltas; i += n_channels) {
+    for (unsigned ch = 0; ch < n_channels; ch++)
+      frame[ch] = unzigzag(frame[ch], deltas[i + ch]);
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+}  // namespace stella
@@ -0,0 +1,17 @@
+// Decoder for time series compressed with core/include/riotee_delta.h.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace stella {
+
+/* One value per channel */
+using DeltaFrame = std::vector<int32_t>;
+
+/* Returns the frames of a packet produced by riotee_delta_finish() or nothing if the packet is malformed. */
+std::optional<std::vector<DeltaFrame>> delta_decode(const uint8_t *buf, size_t size);
+
+}  // namespace stella
@@ -0,0 +1,72 @@
+#include "stella.hpp"
+
+#include <cstring>
+
+namespace stella {
+
+std::vector<uint8_t> Frame::serialize() const {
+  std::vector<uint8_t> buf(1 + sizeof(PacketHeader) + data.size());
+  buf[0] = static_cast<uint8_t>(sizeof(PacketHeader) + data.size());
+  std::memcpy(&buf[1], &hdr, sizeof(PacketHeader));
+  std::memcpy(&buf[1 + sizeof(PacketHeader)], data.data(), data.size());
+  return buf;
+}
+
+std::optional<Frame> Frame::parse(const uint8_t *buf, size_t size) {
+  if ((size < 1 + sizeof(PacketHeader)) || (buf[0] != size - 1))
+    return std::nullopt;
+
+  Frame frame;
+  std::memcpy(&frame.hdr, &buf[1], sizeof(PacketHeader));
+  frame.data.assign(buf + 1 + sizeof(PacketHeader), buf + size);
+  return frame;
+}
+
+namespace {
+/* Fixed upper half of the initialization vector, see core/stella.c */
+const uint8_t kIvTag[4] = {'S', 'T', 'L', 'A'};
+}  // namespace
+
+Cipher::Cipher(uint32_t dev_id, const Key &key) : ccm_(key) {
+  for (size_t i = 0; i < 4; i++)
+    iv_[i] = static_cast<uint8_t>(dev_id >> (8 * i));
+  std::memcpy(&iv_[4], kIvTag, sizeof(kIvTag));
+}
+
+uint32_t Cipher::counter(const Frame &frame, bool uplink) {
+  uint8_t s0 = frame.data.empty() ? 0 : frame.data[0];
+  return (static_cast<uint32_t>(s0) << 16) | (uplink ? frame.hdr.pkt_id : frame.hdr.ack_id);
+}
+
+std::optional<std::vector<uint8_t>> Cipher::open(const Frame &frame, bool uplink) const {
+  if ((frame.data.size() < 3) || (frame.data[1] != frame.data.size() - 3))
+    return std::nullopt;
+  /* The CCM peripheral neither encrypts nor authenticates empty packets */
+  if (frame.data.size() == 3)
+    return std::vector<uint8_t>();
+  if (frame.data.size() < kCcmOverhead)
+    return std::nullopt;
+
+  std::vector<uint8_t> ciphertext(frame.data.begin() + 3, frame.data.end());
+  std::vector<uint8_t> plaintext;
+  if (!ccm_.decrypt(make_nonce(counter(frame, uplink), uplink, iv_), frame.data[0], ciphertext, plaintext))
+    return std::nullopt;
+  return plaintext;
+}
+
+std::vector<uint8_t> Cipher::seal(uint32_t counter, const std::vector<uint8_t> &plaintext, bool uplink) const {
+  uint8_t s0 = static_cast<uint8_t>(counter >> 16);
+  if (plaintext.empty())
+    return {s0, 0, 0};
+
+  std::vector<uint8_t> ciphertext = ccm_.encrypt(make_nonce(counter, uplink, iv_), s0, plaintext);
+
+  std::vector<uint8_t> data(3 + ciphertext.size());
+  data[0] = s0;
+  data[1] = static_cast<uint8_t>(ciphertext.size());
+  data[2] = 0;
+  std::memcpy(&data[3], ciphertext.data(), ciphertext.size());
+  return data;
+}
+
+}  // namespace stella
@@ -0,0 +1,73 @@
+// Stella frame format shared by the host tools. Mirrors core/include/riotee_stella.h.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ccm.hpp"
+
+namespace stella {
+
+struct __attribute__((packed)) PacketHeader {
+  uint32_t dev_id;
+  uint16_t pkt_id;
+  uint16_t ack_id;
+};
+static_assert(sizeof(PacketHeader) == 8, "Header must match riotee_stella_pkt_header_t");
+
+struct __attribute__((packed)) Sync {
+  uint32_t time;
+  uint32_t frame_phase;
+  uint16_t slot;
+  uint16_t n_slots;
+  uint16_t slot_ticks;
+};
+static_assert(sizeof(Sync) == 14, "Sync must match riotee_stella_sync_t");
+
+/* Prefixes of the logical addresses used on air */
+enum class Address : uint8_t {
+  kUplink = 0x5D,
+  kDownlink = 0xF7,
+  kDownlinkSync = 0x8C,
+};
+
+constexpr size_t kMaxLen = 255;
+constexpr size_t kMaxData = kMaxLen - sizeof(PacketHeader);
+/* CCM header (S0, length, RFU) and MIC */
+constexpr size_t kCcmOverhead = 3 + Ccm::kMicSize;
+constexpr size_t kMaxDataEnc = kMaxData - kCcmOverhead;
+constexpr uint16_t kSlotNone = 0xFFFF;
+
+/* Stella packet as received or sent on air: length byte, header and payload */
+struct Frame {
+  PacketHeader hdr;
+  std::vector<uint8_t> data;
+
+  std::vector<uint8_t> serialize() const;
+  /* Returns nothing if the length byte does not match the size of the buffer */
+  static std::optional<Frame> parse(const uint8_t *buf, size_t size);
+};
+
+/* Encryption state of one device as seen by the basestation */
+class Cipher {
+ public:
+  Cipher(uint32_t dev_id, const Key &key);
+
+  /* Packet counter of an encrypted frame: S0 byte followed by the packet ID or, for downlink frames, by the ID of the
+   * acknowledged packet */
+  static uint32_t counter(const Frame &frame, bool uplink = true);
+
+  /* Decrypts the payload of a frame. Returns nothing if the frame is malformed or not authentic. */
+  std::optional<std::vector<uint8_t>> open(const Frame &frame, bool uplink = true) const;
+  /* Encrypts a payload into the data of a frame. Downlink payloads use the counter of the acknowledged frame. */
+  std::vector<uint8_t> seal(uint32_t counter, const std::vector<uint8_t> &plaintext, bool uplink = false) const;
+
+ private:
+  std::array<uint8_t, 8> iv_;
+  Ccm ccm_;
+};
+
+}  // namespace stella
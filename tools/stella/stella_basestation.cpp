@@ -0,0 +1,237 @@
+// Basestation stand-in for load tests without RF hardware.
+//
+// Devices (or a radio model) exchange Stella frames with the basestation in UDP datagrams. Each datagram consists of
+// the prefix of the logical address followed by the frame, starting with the length byte. The acknowledgment is sent
+// back to the address the frame came from.
+//
+// The payload of every new uplink frame is written to stdout as 'up <dev_id> <pkt_id> <payload>'. Downlink messages
+// are read from stdin as 'down <dev_id> <payload>' and delivered in the next acknowledgment to the device. Device IDs
+// and payloads are in hex.
+#include <arpa/inet.h>
+#include <charconv>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "basestation.hpp"
+#include "util.hpp"
+
+using namespace stella;
+
+/* Number of datagrams received/sent with one system call */
+#define BATCH_SIZE 64
+
+static void usage(const char *name) {
+  std::fprintf(stderr,
+               "Usage: %s [-p port] [-k keyfile] [-s n_slots] [-t slot_ticks] [-m mailbox_size]\n"
+               "  -p  UDP port to listen on (default 4242)\n"
+               "  -k  File with device keys for encrypted traffic\n"
+               "  -s  Number of slots per frame, enables sync information in acknowledgments\n"
+               "  -t  Slot length in ticks of a 32kHz clock (default 328)\n"
+               "  -m  Maximum number of queued downlink messages per device (default 16)\n",
+               name);
+}
+
+/* Basestation time in ticks of a 32kHz clock */
+static uint32_t now_ticks(void) {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint32_t>(ts.tv_sec * 32768ULL + (ts.tv_nsec * 32768ULL) / 1000000000ULL);
+}
+
+/* Handles one line from the backend */
+static void handle_command(Basestation &bs, const std::string &line) {
+  std::istringstream fields(line);
+  std::string cmd, dev_id, hex;
+  fields >> cmd >> dev_id >> hex;
+  uint32_t id = 0;
+  const char *end = dev_id.data() + dev_id.size();
+  auto res = std::from_chars(dev_id.data(), end, id, 16);
+  if ((cmd != "down") || dev_id.empty() || (res.ec != std::errc()) || (res.ptr != end)) {
+    std::fprintf(stderr, "Invalid command: %s\n", line.c_str());
+    return;
+  }
+  auto payload = from_hex(hex);
+  if (!payload || !bs.post(id, std::move(*payload)))
+    std::fprintf(stderr, "Cannot queue message for %08x\n", id);
+}
+
+static void print_stats(const Basestation &bs, uint64_t n_tx_dropped) {
+  const BasestationStats &s = bs.stats();
+  std::fprintf(stderr, "devices=%zu rx=%lu duplicates=%lu invalid=%lu downlink=%lu tx_dropped=%lu efficiency=%.3f\n",
+               bs.n_devices(), s.n_rx, s.n_duplicate, s.n_invalid, s.n_downlink, n_tx_dropped,
+               s.air_bytes ? static_cast<double>(s.payload_bytes) / s.air_bytes : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+  BasestationConfig cfg;
+  uint16_t port = 4242;
+  int opt;
+  while ((opt = getopt(argc, argv, "p:k:s:t:m:h")) != -1) {
+    switch (opt) {
+      case 'p':
+        if (!parse_uint(optarg, port)) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 'k': {
+        auto keys = load_keys(optarg);
+        if (!keys) {
+          std::fprintf(stderr, "Failed to load keys from %s\n", optarg);
+          return 1;
+        }
+        cfg.keys = std::move(*keys);
+        break;
+      }
+      case 's':
+        if (!parse_uint(optarg, cfg.n_slots)) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 't':
+        if (!parse_uint(optarg, cfg.slot_ticks)) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 'm':
+        if (!parse_uint(optarg, cfg.mailbox_size)) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  Basestation bs(std::move(cfg));
+  bs.on_uplink([](uint32_t dev_id, uint16_t pkt_id, const std::vector<uint8_t> &payload) {
+    std::printf("up %08x %u %s\n", dev_id, pkt_id, to_hex(payload).c_str());
+  });
+
+  int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if ((sock < 0) || (bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)) {
+    std::perror("Failed to open UDP socket");
+    return 1;
+  }
+
+  /* Large receive buffer to absorb bursts from many devices */
+  int rcvbuf = 8 << 20;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  /* Terminate cleanly on SIGINT/SIGTERM to report statistics */
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigprocmask(SIG_BLOCK, &mask, nullptr);
+  int sfd = signalfd(-1, &mask, 0);
+
+  int epfd = epoll_create1(0);
+  for (int fd : {sock, STDIN_FILENO, sfd}) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+  }
+
+  static uint8_t rx_bufs[BATCH_SIZE][1 + 1 + kMaxLen];
+  static uint8_t tx_bufs[BATCH_SIZE][1 + 1 + kMaxLen];
+  static sockaddr_in peers[BATCH_SIZE];
+  mmsghdr rx_msgs[BATCH_SIZE];
+  mmsghdr tx_msgs[BATCH_SIZE];
+  iovec rx_iovs[BATCH_SIZE];
+  iovec tx_iovs[BATCH_SIZE];
+  std::string input;
+  uint64_t n_tx_dropped = 0;
+  bool running = true;
+
+  while (running) {
+    epoll_event events[3];
+    int n_events = epoll_wait(epfd, events, 3, -1);
+    for (int i = 0; i < n_events; i++) {
+      int fd = events[i].data.fd;
+      if (fd == sfd) {
+        running = false;
+      } else if (fd == STDIN_FILENO) {
+        char buf[4096];
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) {
+          /* Backend closed its end, keep serving devices */
+          epoll_ctl(epfd, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+          continue;
+        }
+        input.append(buf, n);
+        size_t pos;
+        while ((pos = input.find('\n')) != std::string::npos) {
+          handle_command(bs, input.substr(0, pos));
+          input.erase(0, pos + 1);
+        }
+      } else {
+        for (size_t j = 0; j < BATCH_SIZE; j++) {
+          rx_iovs[j] = {rx_bufs[j], sizeof(rx_bufs[j])};
+          rx_msgs[j].msg_hdr = {};
+          rx_msgs[j].msg_hdr.msg_name = &peers[j];
+          rx_msgs[j].msg_hdr.msg_namelen = sizeof(peers[j]);
+          rx_msgs[j].msg_hdr.msg_iov = &rx_iovs[j];
+          rx_msgs[j].msg_hdr.msg_iovlen = 1;
+        }
+        int n_rx = recvmmsg(sock, rx_msgs, BATCH_SIZE, 0, nullptr);
+        uint32_t now = now_ticks();
+        unsigned int n_tx = 0;
+        for (int j = 0; j < n_rx; j++) {
+          size_t size = rx_msgs[j].msg_len;
+          if ((size < 1) || (rx_bufs[j][0] != static_cast<uint8_t>(Address::kUplink)))
+            continue;
+          auto frame = Frame::parse(&rx_bufs[j][1], size - 1);
+          if (!frame)
+            continue;
+          auto ack = bs.handle(*frame, now);
+          if (!ack)
+            continue;
+
+          std::vector<uint8_t> buf = ack->frame.serialize();
+          tx_bufs[n_tx][0] = static_cast<uint8_t>(ack->address);
+          std::memcpy(&tx_bufs[n_tx][1], buf.data(), buf.size());
+          tx_iovs[n_tx] = {tx_bufs[n_tx], 1 + buf.size()};
+          tx_msgs[n_tx].msg_hdr = {};
+          tx_msgs[n_tx].msg_hdr.msg_name = &peers[j];
+          tx_msgs[n_tx].msg_hdr.msg_namelen = rx_msgs[j].msg_hdr.msg_namelen;
+          tx_msgs[n_tx].msg_hdr.msg_iov = &tx_iovs[n_tx];
+          tx_msgs[n_tx].msg_hdr.msg_iovlen = 1;
+          n_tx++;
+        }
+        /* A datagram that cannot be sent is dropped, the device retransmits its frame */
+        for (unsigned int sent = 0; sent < n_tx;) {
+          int n = sendmmsg(sock, &tx_msgs[sent], n_tx - sent, 0);
+          if (n > 0) {
+            sent += n;
+          } else if (errno != EINTR) {
+            n_tx_dropped++;
+            sent++;
+          }
+        }
+        std::fflush(stdout);
+      }
+    }
+  }
+  print_stats(bs, n_tx_dropped);
+  return 0;
+}
@@ -0,0 +1,103 @@
+// Decodes Stella frames captured on air, decrypting the payload of devices with a known key.
+//
+// Reads one frame per line from stdin. A frame is given in hex, starting with the length byte, and may be preceded by
+// the direction 'ul' (default), 'dl' or 'sync' for acknowledgments carrying sync information. With -z, payloads are
+// decoded as time series compressed with riotee_delta.h.
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "delta.hpp"
+#include "stella.hpp"
+#include "util.hpp"
+
+using namespace stella;
+
+static void usage(const char *name) {
+  std::fprintf(stderr, "Usage: %s [-k keyfile] [-z] < frames\n", name);
+}
+
+int main(int argc, char *argv[]) {
+  std::unordered_map<uint32_t, Key> keys;
+  bool delta = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "k:zh")) != -1) {
+    if (opt == 'k') {
+      auto loaded = load_keys(optarg);
+      if (!loaded) {
+        std::fprintf(stderr, "Failed to load keys from %s\n", optarg);
+        return 1;
+      }
+      keys = std::move(*loaded);
+    } else if (opt == 'z') {
+      delta = true;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    std::istringstream fields(line);
+    std::string dir, hex;
+    if (!(fields >> dir))
+      continue;
+    if ((dir == "ul") || (dir == "dl") || (dir == "sync"))
+      std::getline(fields, hex);
+    else
+      hex = line, dir = "ul";
+
+    auto buf = from_hex(hex);
+    std::optional<Frame> frame;
+    if (buf)
+      frame = Frame::parse(buf->data(), buf->size());
+    if (!frame) {
+      std::printf("malformed\n");
+      continue;
+    }
+
+    bool uplink = (dir == "ul");
+    std::vector<uint8_t> payload = frame->data;
+    const char *status = "clear";
+    auto key = keys.find(frame->hdr.dev_id);
+    if (key != keys.end()) {
+      auto plaintext = Cipher(frame->hdr.dev_id, key->second).open(*frame, uplink);
+      if (plaintext) {
+        payload = std::move(*plaintext);
+        status = "authentic";
+      } else {
+        status = "invalid";
+      }
+    }
+    std::printf("%s dev_id=%08x pkt_id=%u ack_id=%u %s", dir.c_str(), frame->hdr.dev_id, frame->hdr.pkt_id,
+                frame->hdr.ack_id, status);
+
+    if ((dir == "sync") && (payload.size() >= sizeof(Sync))) {
+      Sync sync;
+      std::memcpy(&sync, payload.data(), sizeof(Sync));
+      payload.erase(payload.begin(), payload.begin() + sizeof(Sync));
+      std::printf(" time=%u phase=%u slot=%u/%u slot_ticks=%u", sync.time, sync.frame_phase, sync.slot, sync.n_slots,
+                  sync.slot_ticks);
+    }
+    if (delta && !payload.empty()) {
+      auto frames = delta_decode(payload.data(), payload.size());
+      if (!frames) {
+        std::printf(" series=malformed\n");
+        continue;
+      }
+      std::printf(" series=");
+      for (size_t i = 0; i < frames->size(); i++) {
+        for (size_t ch = 0; ch < (*frames)[i].size(); ch++)
+          std::printf("%s%d", ch ? "," : (i ? ";" : ""), (*frames)[i][ch]);
+      }
+      std::printf("\n");
+      continue;
+    }
+    std::printf(" data=%s\n", to_hex(payload).c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+// Load generator for stella_basestation: emulates many devices that send uplink frames over UDP and wait for the
+// acknowledgments, like riotee_stella_send() on a device.
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "stella.hpp"
+#include "util.hpp"
+
+using namespace stella;
+using Clock = std::chrono::steady_clock;
+
+static void usage(const char *name) {
+  std::fprintf(stderr,
+               "Usage: %s [-H host] [-p port] [-n n_devices] [-c n_packets] [-l payload_size] [-k keyfile]\n"
+               "  Each of n_devices sends n_packets frames with payload_size bytes to the basestation.\n",
+               name);
+}
+
+struct VirtualDevice {
+  uint32_t dev_id;
+  uint32_t counter = 0;
+  std::unique_ptr<Cipher> cipher;
+  Clock::time_point t_sent;
+  bool pending = false;
+};
+
+int main(int argc, char *argv[]) {
+  std::string host = "127.0.0.1";
+  uint16_t port = 4242;
+  unsigned int n_devices = 1000;
+  unsigned int n_packets = 10;
+  size_t payload_size = 16;
+  std::unordered_map<uint32_t, Key> keys;
+  int opt;
+  while ((opt = getopt(argc, argv, "H:p:n:c:l:k:h")) != -1) {
+    switch (opt) {
+      case 'H':
+        host = optarg;
+        break;
+      case 'p':
+        port = static_cast<uint16_t>(std::stoul(optarg));
+        break;
+      case 'n':
+        n_devices = std::stoul(optarg);
+        break;
+      case 'c':
+        n_packets = std::stoul(optarg);
+        break;
+      case 'l':
+        payload_size = std::stoul(optarg);
+        break;
+      case 'k': {
+        auto loaded = load_keys(optarg);
+        if (!loaded) {
+          std::fprintf(stderr, "Failed to load keys from %s\n", optarg);
+          return 1;
+        }
+        keys = std::move(*loaded);
+        break;
+      }
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if (payload_size > kMaxDataEnc) {
+    std::fprintf(stderr, "Payload size must not exceed %zu\n", kMaxDataEnc);
+    return 1;
+  }
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if ((sock < 0) || (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) ||
+      (connect(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)) {
+    std::perror("Failed to open UDP socket");
+    return 1;
+  }
+  /* Large receive buffer, so that acknowledgments are not dropped while the next round is sent */
+  int rcvbuf = 8 << 20;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  std::unordered_map<uint32_t, VirtualDevice> devices;
+  for (unsigned int i = 0; i < n_devices; i++) {
+    VirtualDevice dev;
+    dev.dev_id = 0x10000000 + i;
+    auto key = keys.find(dev.dev_id);
+    if (key != keys.end())
+      dev.cipher = std::make_unique<Cipher>(dev.dev_id, key->second);
+    devices.emplace(dev.dev_id, std::move(dev));
+  }
+
+  uint64_t n_sent = 0, n_acked = 0, n_downlink = 0;
+  double rtt_sum_us = 0;
+  auto t_start = Clock::now();
+
+  for (unsigned int round = 0; round < n_packets; round++) {
+    for (auto &[dev_id, dev] : devices) {
+      std::vector<uint8_t> payload(payload_size);
+      for (size_t i = 0; i < payload_size; i++)
+        payload[i] = static_cast<uint8_t>(dev.counter + i);
+
+      Frame frame;
+      frame.hdr = {dev_id, static_cast<uint16_t>(dev.counter), 0};
+      frame.data = dev.cipher ? dev.cipher->seal(dev.counter, payload, true) : payload;
+      dev.counter++;
+
+      std::vector<uint8_t> buf = frame.serialize();
+      buf.insert(buf.begin(), static_cast<uint8_t>(Address::kUplink));
+      dev.t_sent = Clock::now();
+      dev.pending = true;
+      send(sock, buf.data(), buf.size(), 0);
+      n_sent++;
+    }
+
+    /* Collect acknowledgments until all have arrived or none came for 100ms */
+    uint64_t n_pending = devices.size();
+    pollfd pfd = {sock, POLLIN, 0};
+    while ((n_pending > 0) && (poll(&pfd, 1, 100) > 0)) {
+      uint8_t buf[1 + 1 + kMaxLen];
+      ssize_t size = recv(sock, buf, sizeof(buf), 0);
+      if (size < 2)
+        continue;
+      auto frame = Frame::parse(&buf[1], size - 1);
+      if (!frame)
+        continue;
+      auto it = devices.find(frame->hdr.dev_id);
+      if ((it == devices.end()) || !it->second.pending ||
+          (frame->hdr.ack_id != static_cast<uint16_t>(it->second.counter - 1)))
+        continue;
+
+      VirtualDevice &dev = it->second;
+      size_t data_size = frame->data.size();
+      if (dev.cipher) {
+        auto plaintext = dev.cipher->open(*frame, false);
+        if (!plaintext)
+          continue;
+        data_size = plaintext->size();
+      }
+      if (buf[0] == static_cast<uint8_t>(Address::kDownlinkSync))
+        data_size -= std::min(data_size, sizeof(Sync));
+      if (data_size > 0)
+        n_downlink++;
+
+      dev.pending = false;
+      n_pending--;
+      n_acked++;
+      rtt_sum_us += std::chrono::duration<double, std::micro>(Clock::now() - dev.t_sent).count();
+    }
+  }
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - t_start).count();
+  std::printf("devices=%u sent=%lu acked=%lu downlink=%lu rate=%.0f/s mean_rtt=%.0fus\n", n_devices, n_sent, n_acked,
+              n_downlink, n_sent / elapsed, n_acked ? rtt_sum_us / n_acked : 0.0);
+  return n_acked == n_sent ? 0 : 2;
+}
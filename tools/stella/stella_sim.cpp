@@ -0,0 +1,699 @@
+// Discrete-event simulator of many battery-free devices communicating with one basestation over Stella.
+//
+// Each device charges its capacitor from an energy trace, takes a sample whenever the capacitor is charged and sends
+// a batch of samples once the batch is full. Transmissions follow the timing of core/stella.c: HFXO startup, fast
+// radio ramp-up, 1Mbit on-air time and a 100us timeout for the address of the acknowledgment. The basestation is the
+// same implementation as stella_basestation. Any overlap of two transmissions on the channel destroys both.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "basestation.hpp"
+
+using namespace stella;
+
+/* Simulation time in microseconds */
+using Time = int64_t;
+
+namespace {
+
+struct Config {
+  unsigned int n_devices = 100;
+  double duration_s = 3600;
+  /* Harvested power if no trace is given */
+  double power_w = 100e-6;
+  /* Each device scales the trace by a random factor in [1 - spread, 1 + spread] */
+  double power_spread = 0.5;
+  std::string trace_path;
+
+  double capacitance_f = 47e-6;
+  /* Turn-on and turn-off thresholds, maximum voltage of the charger and voltage below which the device resets */
+  double v_high = 4.6;
+  double v_low = 3.1;
+  double v_max = 4.8;
+  double v_reset = 2.0;
+
+  /* Currents drawn from the 2V rail and efficiency of the regulator */
+  double i_sleep_a = 4.5e-6;
+  double i_cpu_a = 4.7e-3;
+  double i_tx_a = 9.0e-3;
+  double i_rx_a = 9.6e-3;
+  double v_rail = 2.0;
+  double efficiency = 0.85;
+
+  /* CPU time for taking a sample and for preparing a packet */
+  Time t_sample = 1000;
+  Time t_packet = 200;
+  /* Minimum time between two samples */
+  Time sample_interval = 0;
+
+  size_t sample_size = 4;
+  unsigned int batch_size = 1;
+  unsigned int max_retries = 3;
+  /* Maximum random backoff before an immediate retry */
+  Time backoff_max = 2000;
+
+  /* Clock error of the devices after drift compensation is drawn from a normal distribution with this standard
+   * deviation */
+  double drift_ppm = 2;
+  bool encrypt = false;
+  uint16_t n_slots = 0;
+  uint16_t slot_ticks = 328;
+  uint64_t seed = 1;
+};
+
+/* Radio timing in microseconds */
+constexpr Time kHfxoStartup = 256;
+constexpr Time kRampUp = 40;
+constexpr Time kAckTimeout = 100;
+/* Time from the end of the uplink until the basestation starts sending the acknowledgment */
+constexpr Time kTurnaround = 60;
+/* Preamble and address */
+constexpr Time kAddressTime = (1 + 4) * 8;
+
+constexpr Time air_time(size_t len) {
+  return static_cast<Time>(Basestation::air_bytes(len)) * 8;
+}
+
+constexpr uint32_t kFirstDevId = 0x10000000;
+
+/* Key shared by a device and the basestation */
+Key device_key(uint64_t seed, uint32_t dev_id) {
+  std::mt19937_64 rng(seed ^ (static_cast<uint64_t>(dev_id) << 32));
+  Key key;
+  for (auto &b : key)
+    b = static_cast<uint8_t>(rng());
+  return key;
+}
+
+inline double to_s(Time t) {
+  return t * 1e-6;
+}
+
+/* Piecewise-constant harvested power, repeated periodically */
+class Trace {
+ public:
+  explicit Trace(double power) : times_{0}, powers_{power}, period_(1e9) {}
+
+  static std::optional<Trace> load(const std::string &path) {
+    std::ifstream file(path);
+    Trace trace(0);
+    trace.times_.clear();
+    trace.powers_.clear();
+    double t, p;
+    while (file >> t >> p) {
+      if (!trace.times_.empty() && (t <= trace.times_.back()))
+        return std::nullopt;
+      trace.times_.push_back(t);
+      trace.powers_.push_back(std::max(p, 0.0));
+    }
+    if (trace.times_.size() < 2)
+      return std::nullopt;
+    /* Last sample lasts as long as the one before */
+    trace.period_ = 2 * trace.times_.back() - trace.times_[trace.times_.size() - 2];
+    return trace;
+  }
+
+  /* Power at time t and end of the constant segment containing t */
+  std::pair<double, double> segment(double t) const {
+    double offset = std::floor(t / period_) * period_;
+    double tp = t - offset;
+    size_t i = std::upper_bound(times_.begin(), times_.end(), tp) - times_.begin();
+    i = (i == 0) ? 0 : i - 1;
+    double end = (i + 1 < times_.size()) ? times_[i + 1] : period_;
+    return {powers_[i], offset + end};
+  }
+
+  double period() const { return period_; }
+
+ private:
+  std::vector<double> times_;
+  std::vector<double> powers_;
+  double period_;
+};
+
+struct Stats {
+  uint64_t n_samples = 0;
+  uint64_t n_samples_delivered = 0;
+  uint64_t n_samples_dropped = 0;
+  uint64_t n_attempts = 0;
+  uint64_t n_acked = 0;
+  uint64_t n_collisions = 0;
+  uint64_t n_ack_lost = 0;
+  uint64_t n_resets = 0;
+  uint64_t payload_bytes = 0;
+  double e_radio_j = 0;
+};
+
+/* A transmission occupying the channel */
+struct Transmission {
+  Time start;
+  Time end;
+  bool corrupted = false;
+};
+
+class Simulator;
+
+class Device {
+ public:
+  Device(Simulator &sim, const Config &cfg, uint32_t dev_id, double power_scale, double trace_offset,
+         double drift_ppm, const Key &key);
+
+  void start();
+
+ private:
+  friend class Simulator;
+
+  double energy_at(double v) const { return 0.5 * cfg_.capacitance_f * v * v; }
+  double load_power(double current) const { return current * cfg_.v_rail / cfg_.efficiency; }
+
+  /* Integrates harvested and sleep power until time t. Returns the time of a reset if the capacitor voltage dropped
+   * below the reset threshold before t. */
+  std::optional<Time> advance(Time t);
+  /* Time at which the capacitor reaches e_target while sleeping, or the time of a reset */
+  std::pair<Time, bool> time_to_energy(double e_target);
+
+  void consume(double energy) { energy_ = std::max(energy_ - energy, 0.0); }
+  /* Basestation received the current batch. Samples that arrived before with a lost acknowledgment count once. */
+  void delivered();
+
+  void wait_charged();
+  void sleep_until(Time t, std::function<void()> next);
+  void reset(Time t);
+  void on_charged();
+  void send();
+  void transmit();
+  void on_result(bool acked, std::shared_ptr<Transmission> ack, const std::vector<uint8_t> &ack_data);
+
+  Simulator &sim_;
+  const Config &cfg_;
+  uint32_t dev_id_;
+  double power_scale_;
+  double trace_offset_;
+  double drift_ppm_;
+  std::unique_ptr<Cipher> cipher_;
+
+  double energy_ = 0;
+  Time t_energy_ = 0;
+  unsigned int batch_ = 0;
+  /* Sequence number of the next sample and of the first sample not yet delivered */
+  uint64_t sample_seq_ = 0;
+  uint64_t delivered_seq_ = 0;
+  unsigned int retries_ = 0;
+  uint32_t pkt_counter_ = 0;
+  /* Incremented on reset to invalidate pending events */
+  uint64_t epoch_ = 0;
+  Time t_last_sample_ = -1;
+
+  /* Sync information from the last acknowledgment and the true time it was received */
+  std::optional<Sync> sync_;
+  Time t_sync_ = 0;
+  Time t_tx_end_ = 0;
+  std::shared_ptr<Transmission> uplink_;
+};
+
+class Simulator {
+ public:
+  Simulator(const Config &cfg, const Trace &trace)
+      : cfg_(cfg), trace_(trace), bs_(make_bs_config(cfg)), rng_(cfg.seed) {
+    bs_.on_uplink([this](uint32_t dev_id, uint16_t, const std::vector<uint8_t> &) {
+      devices_[dev_id - kFirstDevId]->delivered();
+    });
+  }
+
+  void run();
+
+  void schedule(Time t, std::function<void()> fn) { events_.push({t, seq_++, std::move(fn)}); }
+  Time now() const { return now_; }
+  Time end() const { return static_cast<Time>(cfg_.duration_s * 1e6); }
+  std::mt19937_64 &rng() { return rng_; }
+  Stats &stats() { return stats_; }
+  const Trace &trace() const { return trace_; }
+
+  /* Puts a transmission on the channel, destroying it and any overlapping transmission */
+  std::shared_ptr<Transmission> occupy(Time start, Time end) {
+    auto tx = std::make_shared<Transmission>(Transmission{start, end});
+    /* Transmissions are registered ahead of time, so only those that ended before now are certainly irrelevant */
+    active_.erase(std::remove_if(active_.begin(), active_.end(),
+                                 [this](const std::shared_ptr<Transmission> &t) { return t->end <= now_; }),
+                  active_.end());
+    for (auto &other : active_) {
+      if ((other->start < end) && (start < other->end)) {
+        other->corrupted = true;
+        tx->corrupted = true;
+      }
+    }
+    active_.push_back(tx);
+    return tx;
+  }
+
+  /* Uplink frame arrives at the basestation. Returns the acknowledgment if the basestation sends one. */
+  std::optional<Ack> receive(const Frame &frame) {
+    /* Basestation time in ticks of a 32kHz clock */
+    uint32_t ticks = static_cast<uint32_t>((now_ * 32768) / 1000000);
+    return bs_.handle(frame, ticks);
+  }
+
+ private:
+  static BasestationConfig make_bs_config(const Config &cfg) {
+    BasestationConfig bs_cfg;
+    bs_cfg.n_slots = cfg.n_slots;
+    bs_cfg.slot_ticks = cfg.slot_ticks;
+    if (cfg.encrypt) {
+      for (unsigned int i = 0; i < cfg.n_devices; i++)
+        bs_cfg.keys[kFirstDevId + i] = device_key(cfg.seed, kFirstDevId + i);
+    }
+    return bs_cfg;
+  }
+
+  struct Event {
+    Time t;
+    uint64_t seq;
+    std::function<void()> fn;
+    bool operator>(const Event &other) const { return (t > other.t) || ((t == other.t) && (seq > other.seq)); }
+  };
+
+  friend class Device;
+  const Config &cfg_;
+  const Trace &trace_;
+  Basestation bs_;
+  std::mt19937_64 rng_;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+  uint64_t seq_ = 0;
+  Time now_ = 0;
+  std::vector<std::shared_ptr<Transmission>> active_;
+  std::vector<std::unique_ptr<Device>> devices_;
+  Stats stats_;
+};
+
+Device::Device(Simulator &sim, const Config &cfg, uint32_t dev_id, double power_scale, double trace_offset,
+               double drift_ppm, const Key &key)
+    : sim_(sim),
+      cfg_(cfg),
+      dev_id_(dev_id),
+      power_scale_(power_scale),
+      trace_offset_(trace_offset),
+      drift_ppm_(drift_ppm) {
+  if (cfg.encrypt)
+    cipher_ = std::make_unique<Cipher>(dev_id, key);
+}
+
+std::optional<Time> Device::advance(Time t) {
+  double e_reset = energy_at(cfg_.v_reset);
+  double e_max = energy_at(cfg_.v_max);
+  double p_sleep = load_power(cfg_.i_sleep_a);
+  double ts = to_s(t_energy_);
+  double te = to_s(t);
+
+  while (ts < te) {
+    auto [p_harvest, seg_end] = sim_.trace().segment(ts + trace_offset_);
+    double dt = std::min(seg_end - trace_offset_, te) - ts;
+    double p_net = p_harvest * power_scale_ - p_sleep;
+    /* A device that is already off does not reset again */
+    if ((p_net < 0) && (energy_ > e_reset) && (energy_ + p_net * dt < e_reset)) {
+      Time t_reset = static_cast<Time>((ts + (energy_ - e_reset) / -p_net) * 1e6);
+      energy_ = e_reset;
+      t_energy_ = t_reset;
+      return t_reset;
+    }
+    energy_ = std::clamp(energy_ + p_net * dt, std::min(energy_, e_reset), e_max);
+    ts += dt;
+  }
+  t_energy_ = t;
+  return std::nullopt;
+}
+
+std::pair<Time, bool> Device::time_to_energy(double e_target) {
+  double e_reset = energy_at(cfg_.v_reset);
+  double p_sleep = load_power(cfg_.i_sleep_a);
+  double e = energy_;
+  double ts = to_s(t_energy_);
+  double t_end = to_s(sim_.end());
+
+  if (e >= e_target)
+    return {t_energy_, false};
+
+  while (ts < t_end) {
+    auto [p_harvest, seg_end] = sim_.trace().segment(ts + trace_offset_);
+    double dt = seg_end - trace_offset_ - ts;
+    double p_net = p_harvest * power_scale_ - p_sleep;
+    if ((p_net > 0) && (e + p_net * dt >= e_target))
+      return {static_cast<Time>(std::ceil((ts + (e_target - e) / p_net) * 1e6)), false};
+    if ((p_net < 0) && (e > e_reset) && (e + p_net * dt < e_reset))
+      return {static_cast<Time>((ts + (e - e_reset) / -p_net) * 1e6), true};
+    e = std::max(e + p_net * dt, std::min(e, e_reset));
+    ts += dt;
+  }
+  return {sim_.end() + 1, false};
+}
+
+void Device::start() {
+  t_energy_ = 0;
+  energy_ = energy_at(cfg_.v_reset);
+  wait_charged();
+}
+
+void Device::reset(Time t) {
+  sim_.stats().n_resets++;
+  epoch_++;
+  /* Sync information lives in RAM and the local clock restarts */
+  sync_.reset();
+  energy_ = energy_at(cfg_.v_reset);
+  t_energy_ = t;
+  sim_.schedule(t, [this, epoch = epoch_]() {
+    if (epoch == epoch_)
+      wait_charged();
+  });
+}
+
+/* Sleeps until the capacitor has reached the turn-on threshold */
+void Device::wait_charged() {
+  auto [t, is_reset] = time_to_energy(energy_at(cfg_.v_high));
+  if (is_reset) {
+    reset(t);
+    return;
+  }
+  sim_.schedule(t, [this, epoch = epoch_]() {
+    if (epoch != epoch_)
+      return;
+    if (auto t_reset = advance(sim_.now())) {
+      reset(*t_reset);
+      return;
+    }
+    on_charged();
+  });
+}
+
+void Device::sleep_until(Time t, std::function<void()> next) {
+  sim_.schedule(t, [this, epoch = epoch_, next = std::move(next)]() {
+    if (epoch != epoch_)
+      return;
+    if (auto t_reset = advance(sim_.now())) {
+      reset(*t_reset);
+      return;
+    }
+    next();
+  });
+}
+
+void Device::on_charged() {
+  Time now = sim_.now();
+  if ((cfg_.sample_interval > 0) && (t_last_sample_ >= 0) && (now < t_last_sample_ + cfg_.sample_interval)) {
+    sleep_until(t_last_sample_ + cfg_.sample_interval, [this]() { wait_charged(); });
+    return;
+  }
+
+  t_last_sample_ = now;
+  consume(load_power(cfg_.i_cpu_a) * to_s(cfg_.t_sample));
+  sim_.stats().n_samples++;
+  if (batch_ * cfg_.sample_size + cfg_.sample_size <= (cipher_ ? kMaxDataEnc : kMaxData)) {
+    batch_++;
+    sample_seq_++;
+  } else {
+    sim_.stats().n_samples_dropped++;
+  }
+
+  if (batch_ >= cfg_.batch_size)
+    send();
+  else
+    wait_charged();
+}
+
+/* Sends the batch, in the assigned slot if the device is synchronized */
+void Device::send() {
+  if (!sync_ || (sync_->slot == kSlotNone) || (sync_->n_slots == 0)) {
+    transmit();
+    return;
+  }
+
+  /* Same computation as riotee_stella_wait_slot(), the local clock deviating by the drift since the last sync */
+  Time now = sim_.now();
+  int64_t frame_ticks = static_cast<int64_t>(sync_->n_slots) * sync_->slot_ticks;
+  int64_t elapsed = ((now - t_sync_) * 32768) / 1000000;
+  int64_t phase = (sync_->frame_phase + elapsed) % frame_ticks;
+  int64_t delta = static_cast<int64_t>(sync_->slot) * sync_->slot_ticks - phase;
+  while (delta < 4)
+    delta += frame_ticks;
+
+  Time wait = (delta * 1000000) / 32768;
+  Time error = static_cast<Time>((now + wait - t_sync_) * drift_ppm_ * 1e-6);
+  sleep_until(now + std::max<Time>(wait + error, 0), [this]() { transmit(); });
+}
+
+void Device::transmit() {
+  Time now = sim_.now();
+  size_t payload_size = batch_ * cfg_.sample_size;
+  size_t len = sizeof(PacketHeader) + payload_size + (cipher_ ? kCcmOverhead : 0);
+
+  /* Worst case energy of the attempt: packet preparation, HFXO startup, TX and RX until the timeout */
+  double e_cpu = load_power(cfg_.i_cpu_a) * to_s(cfg_.t_packet + kHfxoStartup);
+  double e_tx = load_power(cfg_.i_tx_a) * to_s(kRampUp + air_time(len));
+  double e_rx_max = load_power(cfg_.i_rx_a) * to_s(kRampUp + kAckTimeout + air_time(kMaxLen));
+  if (energy_ - (e_cpu + e_tx + e_rx_max) < energy_at(cfg_.v_low)) {
+    /* Runtime suspends the device until the capacitor has recharged */
+    wait_charged();
+    return;
+  }
+  consume(e_cpu + e_tx);
+  sim_.stats().e_radio_j += e_cpu + e_tx;
+  sim_.stats().n_attempts++;
+
+  Frame frame;
+  frame.hdr = {dev_id_, static_cast<uint16_t>(pkt_counter_), 0};
+  std::vector<uint8_t> payload(payload_size, static_cast<uint8_t>(pkt_counter_));
+  frame.data = cipher_ ? cipher_->seal(pkt_counter_, payload, true) : payload;
+  pkt_counter_++;
+
+  Time tx_start = now + cfg_.t_packet + kHfxoStartup + kRampUp;
+  Time tx_end = tx_start + air_time(len);
+  t_tx_end_ = tx_end;
+  uplink_ = sim_.occupy(tx_start, tx_end);
+
+  sim_.schedule(tx_end, [this, epoch = epoch_, frame, uplink = uplink_]() {
+    if (epoch != epoch_)
+      return;
+    Time rx_ready = sim_.now() + kRampUp;
+    if (uplink->corrupted) {
+      sim_.stats().n_collisions++;
+      sim_.schedule(rx_ready + kAckTimeout, [this, epoch]() {
+        if (epoch == epoch_)
+          on_result(false, nullptr, {});
+      });
+      return;
+    }
+
+    auto ack = sim_.receive(frame);
+    if (!ack) {
+      sim_.schedule(rx_ready + kAckTimeout, [this, epoch]() {
+        if (epoch == epoch_)
+          on_result(false, nullptr, {});
+      });
+      return;
+    }
+
+    Time ack_start = sim_.now() + kTurnaround;
+    Time ack_end = ack_start + air_time(sizeof(PacketHeader) + ack->frame.data.size());
+    auto ack_tx = sim_.occupy(ack_start, ack_end);
+    if (ack_start + kAddressTime > rx_ready + kAckTimeout) {
+      sim_.schedule(rx_ready + kAckTimeout, [this, epoch]() {
+        if (epoch == epoch_)
+          on_result(false, nullptr, {});
+      });
+      return;
+    }
+    sim_.schedule(ack_end, [this, epoch, ack_tx, ack = *ack]() {
+      if (epoch != epoch_)
+        return;
+      std::vector<uint8_t> data = ack.frame.data;
+      if (cipher_ && !ack_tx->corrupted) {
+        auto plaintext = cipher_->open(ack.frame, false);
+        data = plaintext ? *plaintext : std::vector<uint8_t>();
+      }
+      if ((ack.address != Address::kDownlinkSync) || (data.size() < sizeof(Sync)))
+        data.clear();
+      on_result(!ack_tx->corrupted, ack_tx, data);
+    });
+  });
+}
+
+void Device::delivered() {
+  uint64_t first = std::max<uint64_t>(sample_seq_ - batch_, delivered_seq_);
+  sim_.stats().n_samples_delivered += sample_seq_ - first;
+  sim_.stats().payload_bytes += (sample_seq_ - first) * cfg_.sample_size;
+  delivered_seq_ = sample_seq_;
+}
+
+void Device::on_result(bool acked, std::shared_ptr<Transmission> ack, const std::vector<uint8_t> &ack_data) {
+  Time now = sim_.now();
+  double e_rx = load_power(cfg_.i_rx_a) * to_s(now - t_tx_end_);
+  consume(e_rx);
+  sim_.stats().e_radio_j += e_rx;
+  advance(now);
+
+  if (acked) {
+    sim_.stats().n_acked++;
+    if (!ack_data.empty()) {
+      Sync sync;
+      std::memcpy(&sync, ack_data.data(), sizeof(Sync));
+      sync_ = sync;
+      /* Timestamp refers to the start of the acknowledgment */
+      t_sync_ = ack->start;
+    }
+    batch_ = 0;
+    retries_ = 0;
+    wait_charged();
+    return;
+  }
+
+  if (ack != nullptr)
+    sim_.stats().n_ack_lost++;
+
+  if (++retries_ > cfg_.max_retries) {
+    /* Samples may have arrived even though the acknowledgment got lost */
+    sim_.stats().n_samples_dropped += sample_seq_ - std::max<uint64_t>(sample_seq_ - batch_, delivered_seq_);
+    batch_ = 0;
+    retries_ = 0;
+    wait_charged();
+    return;
+  }
+
+  /* Retry right away after a random backoff, as long as there is enough energy */
+  std::uniform_int_distribution<Time> backoff(0, cfg_.backoff_max);
+  sleep_until(now + backoff(sim_.rng()), [this]() { send(); });
+}
+
+void Simulator::run() {
+  std::uniform_real_distribution<double> scale(1 - cfg_.power_spread, 1 + cfg_.power_spread);
+  std::uniform_real_distribution<double> offset(0, trace_.period());
+  std::normal_distribution<double> drift(0, cfg_.drift_ppm);
+  for (unsigned int i = 0; i < cfg_.n_devices; i++) {
+    uint32_t dev_id = kFirstDevId + i;
+    devices_.push_back(std::make_unique<Device>(*this, cfg_, dev_id, scale(rng_), offset(rng_), drift(rng_),
+                                                device_key(cfg_.seed, dev_id)));
+  }
+  for (auto &dev : devices_)
+    dev->start();
+
+  while (!events_.empty() && (events_.top().t <= end())) {
+    Event ev = events_.top();
+    events_.pop();
+    now_ = ev.t;
+    ev.fn();
+  }
+}
+
+void usage(const char *name) {
+  std::fprintf(stderr,
+               "Usage: %s [options]\n"
+               "  -n n_devices      Number of devices (default 100)\n"
+               "  -d seconds        Simulated time (default 3600)\n"
+               "  -T trace          Energy trace with lines '<time in s> <power in W>' (default constant power)\n"
+               "  -P watts          Constant harvested power if no trace is given (default 100e-6)\n"
+               "  -x spread         Devices scale the power by a random factor in [1-x,1+x] (default 0.5)\n"
+               "  -C farad          Capacitance (default 47e-6)\n"
+               "  -z bytes          Size of one sample (default 4)\n"
+               "  -b samples        Samples per packet (default 1)\n"
+               "  -i seconds        Minimum interval between samples (default 0)\n"
+               "  -r retries        Maximum number of retries per packet (default 3)\n"
+               "  -B microseconds   Maximum backoff before a retry (default 2000)\n"
+               "  -s n_slots        Number of slots per frame, 0 for random access (default 0)\n"
+               "  -t ticks          Slot length in ticks of a 32kHz clock (default 328)\n"
+               "  -D ppm            Standard deviation of the residual clock drift of devices (default 2)\n"
+               "  -e                Encrypt packets\n"
+               "  -S seed           Random seed (default 1)\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Config cfg;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:d:T:P:x:C:z:b:i:r:B:s:t:D:eS:h")) != -1) {
+    switch (opt) {
+      case 'n':
+        cfg.n_devices = std::stoul(optarg);
+        break;
+      case 'd':
+        cfg.duration_s = std::stod(optarg);
+        break;
+      case 'T':
+        cfg.trace_path = optarg;
+        break;
+      case 'P':
+        cfg.power_w = std::stod(optarg);
+        break;
+      case 'x':
+        cfg.power_spread = std::stod(optarg);
+        break;
+      case 'C':
+        cfg.capacitance_f = std::stod(optarg);
+        break;
+      case 'z':
+        cfg.sample_size = std::stoul(optarg);
+        break;
+      case 'b':
+        cfg.batch_size = std::stoul(optarg);
+        break;
+      case 'i':
+        cfg.sample_interval = static_cast<Time>(std::stod(optarg) * 1e6);
+        break;
+      case 'r':
+        cfg.max_retries = std::stoul(optarg);
+        break;
+      case 'B':
+        cfg.backoff_max = std::stol(optarg);
+        break;
+      case 's':
+        cfg.n_slots = static_cast<uint16_t>(std::stoul(optarg));
+        break;
+      case 't':
+        cfg.slot_ticks = static_cast<uint16_t>(std::stoul(optarg));
+        break;
+      case 'D':
+        cfg.drift_ppm = std::stod(optarg);
+        break;
+      case 'e':
+        cfg.encrypt = true;
+        break;
+      case 'S':
+        cfg.seed = std::stoull(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  Trace trace(cfg.power_w);
+  if (!cfg.trace_path.empty()) {
+    auto loaded = Trace::load(cfg.trace_path);
+    if (!loaded) {
+      std::fprintf(stderr, "Failed to load trace from %s\n", cfg.trace_path.c_str());
+      return 1;
+    }
+    trace = *loaded;
+  }
+
+  Simulator sim(cfg, trace);
+  sim.run();
+
+  const Stats &s = sim.stats();
+  std::printf("devices=%u duration=%.0fs\n", cfg.n_devices, cfg.duration_s);
+  std::printf("samples=%lu delivered=%lu dropped=%lu\n", s.n_samples, s.n_samples_delivered, s.n_samples_dropped);
+  std::printf("attempts=%lu acked=%lu collisions=%lu ack_lost=%lu resets=%lu\n", s.n_attempts, s.n_acked,
+              s.n_collisions, s.n_ack_lost, s.n_resets);
+  /* Energy of all transmission attempts per unique payload byte received by the basestation */
+  std::printf("delivery_ratio=%.3f energy_per_byte=%.3fuJ throughput=%.1fB/s\n",
+              s.n_attempts ? static_cast<double>(s.n_acked) / s.n_attempts : 0.0,
+              s.payload_bytes ? s.e_radio_j * 1e6 / s.payload_bytes : 0.0, s.payload_bytes / cfg.duration_s);
+  return 0;
+}
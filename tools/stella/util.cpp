@@ -0,0 +1,65 @@
+#include "util.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace stella {
+
+std::optional<std::vector<uint8_t>> from_hex(const std::string &hex) {
+  std::vector<uint8_t> buf;
+  int high = -1;
+  for (char c : hex) {
+    if (std::isspace(static_cast<unsigned char>(c)) || (c == ':'))
+      continue;
+    if (!std::isxdigit(static_cast<unsigned char>(c)))
+      return std::nullopt;
+    int nibble = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10);
+    if (high < 0) {
+      high = nibble;
+    } else {
+      buf.push_back(static_cast<uint8_t>((high << 4) | nibble));
+      high = -1;
+    }
+  }
+  if (high >= 0)
+    return std::nullopt;
+  return buf;
+}
+
+std::string to_hex(const uint8_t *buf, size_t size) {
+  std::string hex;
+  char tmp[3];
+  for (size_t i = 0; i < size; i++) {
+    std::snprintf(tmp, sizeof(tmp), "%02x", buf[i]);
+    hex += tmp;
+  }
+  return hex;
+}
+
+std::optional<std::unordered_map<uint32_t, Key>> load_keys(const std::string &path) {
+  std::ifstream file(path);
+  if (!file)
+    return std::nullopt;
+
+  std::unordered_map<uint32_t, Key> keys;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string dev_id, key_hex;
+    if (!(fields >> dev_id) || (dev_id[0] == '#'))
+      continue;
+    if (!(fields >> key_hex))
+      return std::nullopt;
+
+    auto key = from_hex(key_hex);
+    if (!key || (key->size() != sizeof(Key)))
+      return std::nullopt;
+    Key &dst = keys[static_cast<uint32_t>(std::stoul(dev_id, nullptr, 16))];
+    std::copy(key->begin(), key->end(), dst.begin());
+  }
+  return keys;
+}
+
+}  // namespace stella
@@ -0,0 +1,33 @@
+// Helpers shared by the command line tools.
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ccm.hpp"
+
+namespace stella {
+
+std::optional<std::vector<uint8_t>> from_hex(const std::string &hex);
+std::string to_hex(const uint8_t *buf, size_t size);
+inline std::string to_hex(const std::vector<uint8_t> &buf) {
+  return to_hex(buf.data(), buf.size());
+}
+
+/* Parses a decimal number that must make up the whole string and fit into T. Returns false on error. */
+template <typename T>
+bool parse_uint(const char *str, T &value) {
+  const char *end = str + std::strlen(str);
+  auto res = std::from_chars(str, end, value);
+  return (res.ec == std::errc()) && (res.ptr == end);
+}
+
+/* Reads device keys from a file with one '<dev_id in hex> <key in hex>' pair per line. Returns nothing on error. */
+std::optional<std::unordered_map<uint32_t, Key>> load_keys(const std::string &path);
+
+}  // namespace stella